@@ -0,0 +1,88 @@
+#ifndef ACCESS_LOG_H
+#define ACCESS_LOG_H
+
+#include <string>
+#include <cctype>
+#include <crow.h>
+#include "models.h"
+#include "data_manager.h"
+#include "log_pipeline.h"
+#include "request_timer.h"
+
+// 访问日志中间件：记录每个请求的方法、路由模板、状态码、响应字节数与分阶段耗时
+// （鉴权/数据读写/计算/序列化/日志），经异步日志管道写入独立的访问日志流（data/logs/access）
+struct AccessLogMiddleware {
+    struct context {
+        RequestTimer timer;
+    };
+
+    // 由 main 在日志管道创建后调用；未初始化时只计时不记录
+    void init(DataManager* dm, LogPipeline* lp) {
+        dataManager = dm;
+        pipeline = lp;
+    }
+
+    void before_handle(crow::request&, crow::response&, context& ctx) {
+        ctx.timer.begin();
+    }
+
+    void after_handle(crow::request& req, crow::response& res, context& ctx) {
+        ctx.timer.end();
+        if (pipeline == nullptr || dataManager == nullptr) return;
+
+        AccessLog log;
+        log.method = crow::method_name(req.method);
+        log.route = routeTemplate(req.url);
+        log.status = res.code;
+        log.bytes = responseBytes(res);
+        log.totalUs = ctx.timer.totalMicros();
+        log.authUs = ctx.timer.micros(RequestStage::AUTH);
+        log.dataUs = ctx.timer.micros(RequestStage::DATA);
+        log.computeUs = ctx.timer.micros(RequestStage::COMPUTE);
+        log.serializeUs = ctx.timer.micros(RequestStage::SERIALIZE);
+        log.logUs = ctx.timer.micros(RequestStage::LOG);
+        if (!req.remote_ip_address.empty()) log.ip = req.remote_ip_address;
+        log.createdAt = dataManager->getCurrentTimestamp();
+        pipeline->submit(std::move(log));
+    }
+
+    // 将路径中含数字的段（学号、ID等）替换为 <id>，使同一路由的请求归为一类
+    static std::string routeTemplate(const std::string& url) {
+        std::string path = url.substr(0, url.find('?'));
+        std::string result;
+        size_t pos = 0;
+        while (pos < path.size()) {
+            size_t next = path.find('/', pos + 1);
+            if (next == std::string::npos) next = path.size();
+            std::string segment = path.substr(pos, next - pos); // 含前导 '/'
+            bool hasDigit = false;
+            for (char c : segment) {
+                if (std::isdigit(static_cast<unsigned char>(c))) {
+                    hasDigit = true;
+                    break;
+                }
+            }
+            result += hasDigit ? "/<id>" : segment;
+            pos = next;
+        }
+        return result.empty() ? "/" : result;
+    }
+
+private:
+    DataManager* dataManager = nullptr;
+    LogPipeline* pipeline = nullptr;
+
+    // 文件响应（如日志导出）的内容不在 body 中，取 Content-Length
+    static uint64_t responseBytes(crow::response& res) {
+        if (!res.body.empty()) return res.body.size();
+        const std::string& length = res.get_header_value("Content-Length");
+        if (length.empty()) return 0;
+        try {
+            return std::stoull(length);
+        } catch (...) {
+            return 0;
+        }
+    }
+};
+
+#endif // ACCESS_LOG_H
@@ -4,22 +4,91 @@
 #include <string>
 #include <vector>
 #include <optional>
+#include <unordered_map>
 #include <chrono>
 #include <sstream>
 #include <iomanip>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <openssl/sha.h>
 #include <openssl/hmac.h>
 #include <nlohmann/json.hpp>
 #include "models.h"
 #include "data_manager.h"
+#include "password_hasher.h"
+#include "session_store.h"
+#include "permissions.h"
+#include "log_pipeline.h"
+#include "request_timer.h"
 
 using json = nlohmann::json;
 
 class AuthManager {
 private:
     DataManager* dataManager;
+    PasswordHasher* passwordHasher;
+    LogPipeline* logPipeline;
+    SessionStore sessions;
+    std::mutex persistMutex;
     const std::string JWT_SECRET = "your-secret-key-change-in-production";
 
+    // 后台写回：登录只修改内存，会话变更由后台线程批量落盘
+    static constexpr std::chrono::milliseconds FLUSH_INTERVAL{500};
+    std::thread flusher;
+    std::mutex flushMutex;
+    std::condition_variable flushCv;
+    bool sessionsDirty = false;
+    bool stopping = false;
+
+    // 将会话索引写回 tokens.json
+    void writeSessions() {
+        std::lock_guard<std::mutex> lock(persistMutex);
+        dataManager->saveTokens(sessions.snapshot());
+    }
+
+    // 标记会话已变更，由后台线程合并写回
+    void markSessionsDirty() {
+        {
+            std::lock_guard<std::mutex> lock(flushMutex);
+            sessionsDirty = true;
+        }
+        flushCv.notify_one();
+    }
+
+    // 立即写回会话（吊销等安全相关操作使用，避免重启后失效会话复活）
+    void flushSessions() {
+        {
+            std::lock_guard<std::mutex> lock(flushMutex);
+            sessionsDirty = false;
+        }
+        writeSessions();
+    }
+
+    void flusherLoop() {
+        std::unique_lock<std::mutex> lock(flushMutex);
+        while (true) {
+            flushCv.wait(lock, [this] { return stopping || sessionsDirty; });
+            // 等待一个批处理窗口，合并窗口内的全部变更
+            if (!stopping) {
+                flushCv.wait_for(lock, FLUSH_INTERVAL, [this] { return stopping; });
+            }
+
+            bool dirty = sessionsDirty;
+            sessionsDirty = false;
+            lock.unlock();
+
+            try {
+                if (dirty) writeSessions();
+            } catch (...) {
+                // 写盘失败时丢弃本批，下次变更会再次写回完整会话快照
+            }
+
+            lock.lock();
+            if (stopping && !sessionsDirty) return;
+        }
+    }
+
 public:
     // SHA256哈希（公开方法，供其他类使用）
     std::string sha256(const std::string& str) {
@@ -33,8 +102,19 @@ public:
         return ss.str();
     }
 
+    // 生成密码哈希（带盐PBKDF2，在密码哈希线程池中执行）
+    std::string hashPassword(const std::string& password) {
+        return passwordHasher->hash(password);
+    }
+
+    // 批量生成密码哈希（并行），errors 对应每条的失败原因（成功为空串）
+    std::vector<std::string> hashPasswords(const std::vector<std::string>& passwords,
+                                           std::vector<std::string>* errors = nullptr) {
+        return passwordHasher->hashBatch(passwords, errors);
+    }
+
     // 生成JWT Token
-    std::string generateJWT(const std::string& userId) {
+    std::string generateJWT(const std::string& userId, RoleMask roles) {
         auto now = std::chrono::system_clock::now();
         auto expires = now + std::chrono::hours(24); // 24小时过期
         
@@ -54,63 +134,59 @@ public:
         std::string token = sha256(userId + issuedAt + JWT_SECRET);
         
         // 保存token
-        auto tokens = dataManager->getTokens();
         JWTToken jwtToken{
             token,
             issuedAt,
             expiresAt,
             userId
         };
-        tokens.push_back(jwtToken);
-        dataManager->saveTokens(tokens);
+        sessions.add(jwtToken, roles);
+        markSessionsDirty();
         
         return token;
     }
 
     // 验证Token是否有效
     bool isTokenValid(const std::string& token) {
-        auto tokens = dataManager->getTokens();
-        auto it = std::find_if(tokens.begin(), tokens.end(),
-            [&](const JWTToken& t) { return t.token == token; });
-        
-        if (it == tokens.end()) return false;
-        
-        // 检查过期时间
-        std::tm tm = {};
-        std::istringstream ss(it->expiresAt);
-        ss >> std::get_time(&tm, "%a %b %d %H:%M:%S %Y");
-        
-        auto expires = std::chrono::system_clock::from_time_t(std::mktime(&tm));
-        auto now = std::chrono::system_clock::now();
-        
-        return now < expires;
+        StageScope stage(RequestStage::AUTH);
+        return sessions.findValid(token).has_value();
     }
 
     // 从Token获取用户ID
     std::optional<std::string> getUserIdFromToken(const std::string& token) {
-        auto tokens = dataManager->getTokens();
-        auto it = std::find_if(tokens.begin(), tokens.end(),
-            [&](const JWTToken& t) { return t.token == token; });
-        
-        if (it == tokens.end()) return std::nullopt;
-        
-        // 检查过期
-        std::tm tm = {};
-        std::istringstream ss(it->expiresAt);
-        ss >> std::get_time(&tm, "%a %b %d %H:%M:%S %Y");
-        
-        auto expires = std::chrono::system_clock::from_time_t(std::mktime(&tm));
-        auto now = std::chrono::system_clock::now();
-        
-        if (now >= expires) return std::nullopt;
-        
-        return it->userId;
+        auto session = sessions.findValid(token);
+        if (!session.has_value()) return std::nullopt;
+        return session->userId;
     }
 
-    AuthManager(DataManager* dm) : dataManager(dm) {}
+    AuthManager(DataManager* dm, PasswordHasher* ph, LogPipeline* lp)
+        : dataManager(dm), passwordHasher(ph), logPipeline(lp) {
+        std::unordered_map<std::string, RoleMask> roles;
+        for (const auto& user : dataManager->getUsers()) {
+            roles[user.id] = Role::fromString(user.role);
+        }
+        sessions.load(dataManager->getTokens(), [&](const std::string& userId) {
+            auto it = roles.find(userId);
+            return it != roles.end() ? it->second : Role::NONE;
+        });
+        flusher = std::thread([this] { flusherLoop(); });
+    }
+
+    ~AuthManager() {
+        {
+            std::lock_guard<std::mutex> lock(flushMutex);
+            stopping = true;
+        }
+        flushCv.notify_all();
+        if (flusher.joinable()) flusher.join();
+    }
 
-    // 用户登录
+    AuthManager(const AuthManager&) = delete;
+    AuthManager& operator=(const AuthManager&) = delete;
+
+    // 用户登录（密码哈希池繁忙时抛出 PasswordHasherBusy）
     std::optional<std::pair<std::string, User>> login(const std::string& username, const std::string& password, const std::string& role) {
+        StageScope stage(RequestStage::AUTH);
         auto users = dataManager->getUsers();
         
         // 查找用户
@@ -119,20 +195,42 @@ public:
                 return u.username == username && u.role == role; 
             });
         
-        if (it == users.end()) return std::nullopt;
+        if (it == users.end()) {
+            // 同样做一次完整的密码校验，使不存在的用户名与密码错误耗时相同
+            passwordHasher->tryVerify(password, passwordHasher->dummyHash());
+            return std::nullopt;
+        }
         
         // 验证密码哈希
-        std::string passwordHash = sha256(password);
-        if (it->passwordHash != passwordHash) {
+        auto check = passwordHasher->tryVerify(password, it->passwordHash);
+        if (!check.valid) {
             return std::nullopt;
         }
+
+        // 旧版SHA256或成本参数已调整的哈希，登录成功后透明升级
+        // 计算新哈希期间用户列表可能已被修改：在同一把锁内重新读取，只在该用户仍是刚校验过的旧哈希时替换
+        if (check.needsRehash) {
+            try {
+                std::string verifiedHash = it->passwordHash;
+                std::string upgradedHash = passwordHasher->tryHash(password);
+                std::string now = dataManager->getCurrentTimestamp();
+                dataManager->updateUsers([&](std::vector<User>& current) {
+                    auto user = std::find_if(current.begin(), current.end(),
+                        [&](const User& u) { return u.id == it->id; });
+                    if (user == current.end() || user->passwordHash != verifiedHash) return;
+                    user->passwordHash = upgradedHash;
+                    user->updatedAt = now;
+                });
+            } catch (const PasswordHasherBusy&) {
+                // 池繁忙时跳过升级，下次登录再试
+            }
+        }
         
         // 生成Token
-        std::string token = generateJWT(it->id);
+        std::string token = generateJWT(it->id, Role::fromString(it->role));
         
-        // 记录操作日志
-        auto logs = dataManager->getOperationLogs();
-        OperationLog log{
+        // 记录操作日志（写入异步日志管道）
+        logPipeline->submit(OperationLog{
             dataManager->generateId(),
             it->id,
             it->username,
@@ -140,27 +238,40 @@ public:
             "认证",
             "", // IP在实际使用中需要从请求中获取
             dataManager->getCurrentTimestamp()
-        };
-        logs.push_back(log);
-        dataManager->saveOperationLogs(logs);
+        });
         
         return std::make_pair(token, *it);
     }
 
     // 用户登出
     bool logout(const std::string& token) {
-        auto tokens = dataManager->getTokens();
-        auto it = std::remove_if(tokens.begin(), tokens.end(),
-            [&](const JWTToken& t) { return t.token == token; });
-        
-        if (it == tokens.end()) return false;
-        
-        tokens.erase(it, tokens.end());
-        dataManager->saveTokens(tokens);
-        
+        if (!sessions.remove(token)) return false;
+        markSessionsDirty();
         return true;
     }
 
+    // 吊销某用户的全部会话（重置密码、删除用户时调用），返回吊销数量
+    size_t revokeUserSessions(const std::string& userId) {
+        size_t count = sessions.revokeUser(userId);
+        if (count > 0) flushSessions();
+        return count;
+    }
+
+    // 批量吊销多个用户的会话，只写回一次
+    size_t revokeUserSessions(const std::vector<std::string>& userIds) {
+        size_t count = 0;
+        for (const auto& userId : userIds) {
+            count += sessions.revokeUser(userId);
+        }
+        if (count > 0) flushSessions();
+        return count;
+    }
+
+    // 获取活跃会话（userId 为空时返回全部）
+    std::vector<JWTToken> getActiveSessions(const std::string& userId = "") {
+        return sessions.activeSessions(userId);
+    }
+
     // 验证Token
     bool verifyToken(const std::string& token) {
         return isTokenValid(token);
@@ -168,6 +279,7 @@ public:
 
     // 获取当前用户信息
     std::optional<User> getCurrentUser(const std::string& token) {
+        StageScope stage(RequestStage::AUTH);
         auto userId = getUserIdFromToken(token);
         if (!userId.has_value()) return std::nullopt;
         
@@ -198,8 +310,7 @@ public:
         std::string newPwd = trim(newPassword);
 
         // 验证旧密码
-        std::string oldHash = sha256(oldPwd);
-        if (user.value().passwordHash != oldHash) {
+        if (!passwordHasher->verify(oldPwd, user.value().passwordHash).valid) {
             return 2; // old password incorrect
         }
         
@@ -210,13 +321,12 @@ public:
         
         if (it == users.end()) return 3;
         
-        it->passwordHash = sha256(newPwd);
+        it->passwordHash = passwordHasher->hash(newPwd);
         it->updatedAt = dataManager->getCurrentTimestamp();
         dataManager->saveUsers(users);
         
         // 记录操作日志
-        auto logs = dataManager->getOperationLogs();
-        OperationLog log{
+        logPipeline->submit(OperationLog{
             dataManager->generateId(),
             user.value().id,
             user.value().username,
@@ -224,27 +334,20 @@ public:
             "用户管理",
             "",
             dataManager->getCurrentTimestamp()
-        };
-        logs.push_back(log);
-        dataManager->saveOperationLogs(logs);
+        });
         
         return 0;
     }
 
-    // 检查权限
-    bool hasPermission(const std::string& token, const std::vector<std::string>& requiredRoles) {
-        auto user = getCurrentUser(token);
-        if (!user.has_value()) return false;
-        
-        // 管理员有所有权限
-        if (user.value().role == "admin") return true;
-        
-        // 检查是否需要特定角色
-        for (const auto& role : requiredRoles) {
-            if (user.value().role == role) return true;
-        }
-        
-        return false;
+    // 检查权限：会话中的角色掩码与路由所需掩码按位与
+    bool hasPermission(const std::string& token, RoleMask required) {
+        StageScope stage(RequestStage::AUTH);
+        return (sessions.rolesOf(token) & required) != 0;
+    }
+
+    // 用户角色变更后同步其会话的角色掩码
+    void updateUserRole(const std::string& userId, const std::string& role) {
+        sessions.updateRoles(userId, Role::fromString(role));
     }
 
     // 获取用户角色
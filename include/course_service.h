@@ -105,7 +105,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
             return errorResponse("Forbidden", "Admin only", 403);
         }
 
@@ -176,7 +176,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
             return errorResponse("Forbidden", "Admin only", 403);
         }
 
@@ -231,7 +231,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
             return errorResponse("Forbidden", "Admin only", 403);
         }
 
@@ -373,7 +373,7 @@ public:
         }
         
         // 验证权限（管理员和教师可以选课）
-        if (!authManager->hasPermission(token.substr(7), {"admin", "teacher"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::STAFF)) {
             return errorResponse("Forbidden", "Admin or Teacher only", 403);
         }
 
@@ -431,8 +431,7 @@ public:
             dataManager->getCurrentTimestamp(),
             dataManager->getCurrentTimestamp()
         };
-        grades.push_back(newGrade);
-        dataManager->saveGrades(grades);
+        dataManager->addGrade(newGrade);
 
         // 记录日志
         auto currentUser = authManager->getCurrentUser(token.substr(7));
@@ -466,7 +465,7 @@ public:
         }
         
         // 验证权限（管理员和教师可以取消选课）
-        if (!authManager->hasPermission(token.substr(7), {"admin", "teacher"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::STAFF)) {
             return errorResponse("Forbidden", "Admin or Teacher only", 403);
         }
 
@@ -500,8 +499,7 @@ public:
         }
 
         // 删除选课记录
-        grades.erase(gradeIt);
-        dataManager->saveGrades(grades);
+        dataManager->removeGrade(gradeIt->id);
 
         // 记录日志
         auto currentUser = authManager->getCurrentUser(token.substr(7));
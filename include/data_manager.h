@@ -6,24 +6,64 @@
 #include <fstream>
 #include <filesystem>
 #include <mutex>
+#include <atomic>
+#include <functional>
 #include <nlohmann/json.hpp>
 #include "models.h"
+#include "log_store.h"
+#include "log_query.h"
+#include "grade_stats.h"
+#include "request_timer.h"
 
 using json = nlohmann::json;
 namespace fs = std::filesystem;
 
+// 用户操作日志分页结果（从新到旧）
+struct OperationLogPage {
+    std::vector<OperationLog> logs;
+    size_t total = 0;
+    std::optional<LogPosition> next; // 下一页游标（本页最早一条的位置），没有更早日志时为空
+};
+
+// 数据集合版本号：每次保存对应集合后递增，供统计结果缓存校验
+struct DataVersions {
+    uint64_t grades = 0;
+    uint64_t students = 0;
+    uint64_t courses = 0;
+};
+
+// 日志检索结果（从新到旧）
+template<typename T>
+struct LogQueryPage {
+    std::vector<T> logs;
+    size_t total = 0;
+};
+
 class DataManager {
 private:
     std::string dataDir;
     std::mutex mutex;
+    LogQueryIndex<OperationLog> operationLogQuery;
+    LogQueryIndex<SystemLog> systemLogQuery;
+    GradeStatsIndex gradeStats;               // 成绩统计累计量，随成绩/学生/课程保存同步更新
+    std::atomic<uint64_t> gradesVersion{0};   // 集合版本号在数据与累计量更新之后递增
+    std::atomic<uint64_t> studentsVersion{0};
+    std::atomic<uint64_t> coursesVersion{0};
+    LogStore<OperationLog> operationLogStore; // 日志段文件自带锁，不占用数据文件锁
+    LogStore<SystemLog> systemLogStore;
+    LogStore<AccessLog> accessLogStore;     // 访问日志，仅用于性能分析，不纳入备份
     
     // 数据文件路径
     std::string getUsersFile() const { return dataDir + "/users.json"; }
     std::string getStudentsFile() const { return dataDir + "/students.json"; }
     std::string getCoursesFile() const { return dataDir + "/courses.json"; }
     std::string getGradesFile() const { return dataDir + "/grades.json"; }
-    std::string getOperationLogsFile() const { return dataDir + "/operation_logs.json"; }
-    std::string getSystemLogsFile() const { return dataDir + "/system_logs.json"; }
+    std::string getOperationLogsDir() const { return dataDir + "/logs/operation"; }
+    std::string getSystemLogsDir() const { return dataDir + "/logs/system"; }
+    std::string getAccessLogsDir() const { return dataDir + "/logs/access"; }
+    // 旧版日志文件（整体 JSON 数组），启动时迁移为分段存储
+    std::string getLegacyOperationLogsFile() const { return dataDir + "/operation_logs.json"; }
+    std::string getLegacySystemLogsFile() const { return dataDir + "/system_logs.json"; }
     std::string getBackupsFile() const { return dataDir + "/backups.json"; }
     std::string getSettingsFile() const { return dataDir + "/settings.json"; }
     std::string getTokensFile() const { return dataDir + "/tokens.json"; }
@@ -31,6 +71,7 @@ private:
     // 通用文件读写方法
     template<typename T>
     std::vector<T> readData(const std::string& filePath) {
+        StageScope stage(RequestStage::DATA);
         std::vector<T> items;
         std::ifstream file(filePath);
         if (!file.is_open()) {
@@ -53,15 +94,21 @@ private:
 
     template<typename T>
     void writeData(const std::string& filePath, const std::vector<T>& items) {
+        StageScope stage(RequestStage::DATA);
         json j = json::array();
         for (const auto& item : items) {
             j.push_back(item);
         }
         
-        std::ofstream file(filePath);
-        if (file.is_open()) {
+        // 先写临时文件再原子替换，避免写入中途失败留下半个文件
+        std::string tmpPath = filePath + ".tmp";
+        {
+            std::ofstream file(tmpPath);
+            if (!file.is_open()) return;
             file << j.dump(2);
         }
+        std::error_code ec;
+        fs::rename(tmpPath, filePath, ec);
     }
 
 public:
@@ -141,9 +188,55 @@ public:
     }
 
 private:
+    // 将旧版 JSON 数组日志导入分段存储，导入后重命名为 *.migrated 避免重复导入
+    template<typename T>
+    void migrateLegacyLogs(const std::string& legacyFile, LogStore<T>& store) {
+        if (!fs::exists(legacyFile)) return;
+        if (store.empty()) {
+            store.append(readData<T>(legacyFile));
+        }
+        std::error_code ec;
+        fs::rename(legacyFile, legacyFile + ".migrated", ec);
+    }
+
+    // 从备份恢复日志：新版备份包含段目录，旧版备份只有 JSON 数组文件
+    template<typename T>
+    void restoreLogs(const std::string& backupDir, const std::string& subDir,
+                     const std::string& legacyName, LogStore<T>& store) {
+        std::string segmentDir = backupDir + "/logs/" + subDir;
+        std::string legacyFile = backupDir + "/" + legacyName;
+        if (fs::exists(segmentDir)) {
+            store.replaceFrom(segmentDir);
+        } else if (fs::exists(legacyFile)) {
+            store.replaceWith(readData<T>(legacyFile));
+        }
+    }
+
+    void rebuildStatistics() {
+        std::lock_guard<std::mutex> lock(mutex);
+        gradeStats.rebuild(readData<Grade>(getGradesFile()), readData<Student>(getStudentsFile()),
+                           readData<Course>(getCoursesFile()));
+        gradesVersion++;
+        studentsVersion++;
+        coursesVersion++;
+    }
+
+    template<typename T>
+    static LogQueryPage<T> readQueryPage(const LogStore<T>& store, const typename LogQueryIndex<T>::Result& hits) {
+        LogQueryPage<T> page;
+        page.total = hits.total;
+        for (auto& log : store.readAt(hits.positions)) {
+            if (log.has_value()) page.logs.push_back(std::move(log.value()));
+        }
+        return page;
+    }
 
 public:
-    DataManager(const std::string& dir) : dataDir(dir) {
+    DataManager(const std::string& dir)
+        : dataDir(dir),
+          operationLogStore(getOperationLogsDir()),
+          systemLogStore(getSystemLogsDir()),
+          accessLogStore(getAccessLogsDir()) {
         // 确保数据目录存在
         if (!fs::exists(dataDir)) {
             fs::create_directories(dataDir);
@@ -151,6 +244,21 @@ public:
         
         // 初始化默认数据
         initializeDefaultData();
+
+        // 由数据文件建立成绩统计累计量，之后随每次保存增量维护
+        rebuildStatistics();
+
+        // 建立日志检索索引（同时提供用户操作日志分页），之后由日志写入同步维护
+        operationLogStore.subscribe({
+            [this] { operationLogQuery.clear(); },
+            [this](const OperationLog& log, const LogPosition& pos) { operationLogQuery.add(log, pos); },
+            [this](const std::vector<uint64_t>& keys) { operationLogQuery.removeSegments(keys); }
+        });
+        systemLogStore.subscribe({
+            [this] { systemLogQuery.clear(); },
+            [this](const SystemLog& log, const LogPosition& pos) { systemLogQuery.add(log, pos); },
+            [this](const std::vector<uint64_t>& keys) { systemLogQuery.removeSegments(keys); }
+        });
     }
 
     void initializeDefaultData() {
@@ -160,7 +268,8 @@ public:
                 7,   // backupInterval
                 30,  // logRetentionDays
                 5,   // maxLoginAttempts
-                30   // sessionTimeout
+                30,  // sessionTimeout
+                {}   // logPolicies：记录全部操作
             };
             std::vector<SystemSettings> settingsVec = {settings};
             writeData(getSettingsFile(), settingsVec);
@@ -222,12 +331,8 @@ public:
         if (!fs::exists(getGradesFile())) {
             writeData(getGradesFile(), std::vector<Grade>{});
         }
-        if (!fs::exists(getOperationLogsFile())) {
-            writeData(getOperationLogsFile(), std::vector<OperationLog>{});
-        }
-        if (!fs::exists(getSystemLogsFile())) {
-            writeData(getSystemLogsFile(), std::vector<SystemLog>{});
-        }
+        migrateLegacyLogs(getLegacyOperationLogsFile(), operationLogStore);
+        migrateLegacyLogs(getLegacySystemLogsFile(), systemLogStore);
         if (!fs::exists(getBackupsFile())) {
             writeData(getBackupsFile(), std::vector<Backup>{});
         }
@@ -247,6 +352,14 @@ public:
         writeData(getUsersFile(), users);
     }
 
+    // 在同一把锁内读取-修改-写回用户列表（原子变更）
+    void updateUsers(const std::function<void(std::vector<User>&)>& mutator) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto users = readData<User>(getUsersFile());
+        mutator(users);
+        writeData(getUsersFile(), users);
+    }
+
     // 学生管理
     std::vector<Student> getStudents() {
         std::lock_guard<std::mutex> lock(mutex);
@@ -256,6 +369,8 @@ public:
     void saveStudents(const std::vector<Student>& students) {
         std::lock_guard<std::mutex> lock(mutex);
         writeData(getStudentsFile(), students);
+        gradeStats.applyStudents(students);
+        studentsVersion++;
     }
 
     // 课程管理
@@ -267,6 +382,8 @@ public:
     void saveCourses(const std::vector<Course>& courses) {
         std::lock_guard<std::mutex> lock(mutex);
         writeData(getCoursesFile(), courses);
+        gradeStats.applyCourses(courses);
+        coursesVersion++;
     }
 
     // 成绩管理
@@ -275,33 +392,116 @@ public:
         return readData<Grade>(getGradesFile());
     }
 
+    // 整体保存成绩列表，统计累计量按新旧差异更新（批量导入等）
     void saveGrades(const std::vector<Grade>& grades) {
         std::lock_guard<std::mutex> lock(mutex);
         writeData(getGradesFile(), grades);
+        gradeStats.applyGrades(grades);
+        gradesVersion++;
     }
 
-    // 操作日志
-    std::vector<OperationLog> getOperationLogs() {
+    // 单条成绩的增、改、删：在同一把锁内读取-修改-写回，统计累计量只按这一条更新
+    void addGrade(const Grade& grade) {
         std::lock_guard<std::mutex> lock(mutex);
-        return readData<OperationLog>(getOperationLogsFile());
+        auto grades = readData<Grade>(getGradesFile());
+        grades.push_back(grade);
+        writeData(getGradesFile(), grades);
+        gradeStats.putGrade(grade);
+        gradesVersion++;
     }
 
-    void saveOperationLogs(const std::vector<OperationLog>& logs) {
+    // 修改成绩，返回修改后的成绩；不存在时返回 nullopt
+    std::optional<Grade> updateGrade(const std::string& id, const std::function<void(Grade&)>& mutator) {
         std::lock_guard<std::mutex> lock(mutex);
-        writeData(getOperationLogsFile(), logs);
+        auto grades = readData<Grade>(getGradesFile());
+        auto it = std::find_if(grades.begin(), grades.end(), [&](const Grade& g) { return g.id == id; });
+        if (it == grades.end()) return std::nullopt;
+        mutator(*it);
+        writeData(getGradesFile(), grades);
+        gradeStats.putGrade(*it);
+        gradesVersion++;
+        return *it;
     }
 
-    // 系统日志
-    std::vector<SystemLog> getSystemLogs() {
+    // 删除成绩，不存在时返回 false
+    bool removeGrade(const std::string& id) {
         std::lock_guard<std::mutex> lock(mutex);
-        return readData<SystemLog>(getSystemLogsFile());
+        auto grades = readData<Grade>(getGradesFile());
+        auto it = std::find_if(grades.begin(), grades.end(), [&](const Grade& g) { return g.id == id; });
+        if (it == grades.end()) return false;
+        grades.erase(it);
+        writeData(getGradesFile(), grades);
+        gradeStats.removeGrade(id);
+        gradesVersion++;
+        return true;
     }
 
-    void saveSystemLogs(const std::vector<SystemLog>& logs) {
-        std::lock_guard<std::mutex> lock(mutex);
-        writeData(getSystemLogsFile(), logs);
+    // 成绩统计累计量（全局/课程/班级/学生），读取为 O(1)
+    const GradeStatsIndex& statistics() const { return gradeStats; }
+
+    DataVersions versions() const {
+        return DataVersions{gradesVersion.load(), studentsVersion.load(), coursesVersion.load()};
     }
 
+    // 操作日志（按写入顺序）
+    std::vector<OperationLog> getOperationLogs() {
+        StageScope stage(RequestStage::DATA);
+        return operationLogStore.readAll();
+    }
+
+    // 追加一批操作日志（只写入当前段末尾）
+    void appendOperationLogs(const std::vector<OperationLog>& newLogs) {
+        operationLogStore.append(newLogs);
+    }
+
+    LogStore<OperationLog>& operationLogs() { return operationLogStore; }
+
+    // 按索引读取某用户的一页操作日志（从新到旧），只读取该用户的日志
+    OperationLogPage getUserOperationLogs(const std::string& userId, const std::optional<LogPosition>& before,
+                                          size_t skip, size_t limit) {
+        StageScope stage(RequestStage::DATA);
+        OperationLogPage page;
+        auto slice = operationLogQuery.userPage(userId, before, skip, limit);
+        page.total = slice.total;
+        for (auto& log : operationLogStore.readAt(slice.positions)) {
+            if (log.has_value()) page.logs.push_back(std::move(log.value()));
+        }
+        if (slice.hasMore && !slice.positions.empty()) page.next = slice.positions.back();
+        return page;
+    }
+
+    // 系统日志（按写入顺序）
+    std::vector<SystemLog> getSystemLogs() {
+        StageScope stage(RequestStage::DATA);
+        return systemLogStore.readAll();
+    }
+
+    // 按条件检索系统日志（级别/模块位图求交 + 按段日期剪枝），只读取本页日志
+    LogQueryPage<SystemLog> querySystemLogs(const LogQuery& query) {
+        StageScope stage(RequestStage::DATA);
+        return readQueryPage(systemLogStore, systemLogQuery.query(query));
+    }
+
+    // 按条件检索操作日志（模块/用户/时间）
+    LogQueryPage<OperationLog> queryOperationLogs(const LogQuery& query) {
+        StageScope stage(RequestStage::DATA);
+        return readQueryPage(operationLogStore, operationLogQuery.query(query));
+    }
+
+    // 追加一批系统日志（只写入当前段末尾）
+    void appendSystemLogs(const std::vector<SystemLog>& newLogs) {
+        systemLogStore.append(newLogs);
+    }
+
+    LogStore<SystemLog>& systemLogs() { return systemLogStore; }
+
+    // 追加一批访问日志
+    void appendAccessLogs(const std::vector<AccessLog>& newLogs) {
+        accessLogStore.append(newLogs);
+    }
+
+    LogStore<AccessLog>& accessLogs() { return accessLogStore; }
+
     // 备份管理
     std::vector<Backup> getBackups() {
         std::lock_guard<std::mutex> lock(mutex);
@@ -318,7 +518,7 @@ public:
         std::lock_guard<std::mutex> lock(mutex);
         auto settings = readData<SystemSettings>(getSettingsFile());
         if (settings.empty()) {
-            return SystemSettings{7, 30, 5, 30};
+            return SystemSettings{7, 30, 5, 30, {}};
         }
         return settings[0];
     }
@@ -340,6 +540,13 @@ public:
         writeData(getTokensFile(), tokens);
     }
 
+    // 导出文件目录（日志导出先写入此目录，再由 Crow 按块发送）
+    std::string getExportDir() {
+        std::string dir = dataDir + "/exports";
+        fs::create_directories(dir);
+        return dir;
+    }
+
     // 备份数据
     bool backupData(const std::string& backupName, const std::string& createdBy) {
         try {
@@ -348,8 +555,7 @@ public:
             
             // 复制所有数据文件
             std::vector<std::string> files = {
-                "users.json", "students.json", "courses.json", "grades.json",
-                "operation_logs.json", "system_logs.json", "settings.json"
+                "users.json", "students.json", "courses.json", "grades.json", "settings.json"
             };
             
             long long totalSize = 0;
@@ -361,6 +567,10 @@ public:
                     totalSize += fs::file_size(src);
                 }
             }
+
+            // 复制日志段目录
+            totalSize += operationLogStore.copyTo(backupDir + "/logs/operation");
+            totalSize += systemLogStore.copyTo(backupDir + "/logs/system");
             
             // 记录备份信息
             auto backups = getBackups();
@@ -393,8 +603,7 @@ public:
             
             // 恢复所有文件
             std::vector<std::string> files = {
-                "users.json", "students.json", "courses.json", "grades.json",
-                "operation_logs.json", "system_logs.json", "settings.json"
+                "users.json", "students.json", "courses.json", "grades.json", "settings.json"
             };
             
             for (const auto& file : files) {
@@ -404,6 +613,10 @@ public:
                     fs::copy_file(src, dst, fs::copy_options::overwrite_existing);
                 }
             }
+
+            restoreLogs(backupDir, "operation", "operation_logs.json", operationLogStore);
+            restoreLogs(backupDir, "system", "system_logs.json", systemLogStore);
+            rebuildStatistics();
             
             return true;
         } catch (...) {
@@ -433,34 +646,34 @@ public:
         }
     }
 
-    // 清理日志
-    void cleanLogs(int retentionDays) {
-        auto now = std::chrono::system_clock::now();
-        auto cutoff = now - std::chrono::hours(24 * retentionDays);
-        
-        // 清理操作日志
-        auto opLogs = getOperationLogs();
-        opLogs.erase(std::remove_if(opLogs.begin(), opLogs.end(),
-            [&](const OperationLog& log) {
-                std::tm tm = {};
-                std::istringstream ss(log.createdAt);
-                ss >> std::get_time(&tm, "%a %b %d %H:%M:%S %Y");
-                auto logTime = std::chrono::system_clock::from_time_t(std::mktime(&tm));
-                return logTime < cutoff;
-            }), opLogs.end());
-        saveOperationLogs(opLogs);
-        
-        // 清理系统日志
-        auto sysLogs = getSystemLogs();
-        sysLogs.erase(std::remove_if(sysLogs.begin(), sysLogs.end(),
-            [&](const SystemLog& log) {
-                std::tm tm = {};
-                std::istringstream ss(log.createdAt);
-                ss >> std::get_time(&tm, "%a %b %d %H:%M:%S %Y");
-                auto logTime = std::chrono::system_clock::from_time_t(std::mktime(&tm));
-                return logTime < cutoff;
-            }), sysLogs.end());
-        saveSystemLogs(sysLogs);
+    // 清理日志：删除日期早于保留期限的整段文件（按天粒度），返回回收情况
+    // 每次只删除一个段并释放存储锁，避免长时间阻塞日志写入；删除的段在本轮结束后一次性通知索引
+    LogCleanResult cleanLogs(int retentionDays) {
+        auto cutoff = std::chrono::system_clock::now() - std::chrono::hours(24 * retentionDays);
+        std::time_t tt = std::chrono::system_clock::to_time_t(cutoff);
+        std::tm tm{};
+    #ifdef _WIN32
+        localtime_s(&tm, &tt);
+    #else
+        localtime_r(&tt, &tm);
+    #endif
+        char cutoffDay[16];
+        std::strftime(cutoffDay, sizeof(cutoffDay), "%Y-%m-%d", &tm);
+
+        LogCleanResult result;
+        auto drain = [&](auto& store) {
+            std::vector<uint64_t> removedKeys;
+            while (true) {
+                auto step = store.removeBefore(cutoffDay, 1, &removedKeys);
+                if (step.segments == 0) break;
+                result += step;
+            }
+            store.notifyRemoved(removedKeys);
+        };
+        drain(operationLogStore);
+        drain(systemLogStore);
+        drain(accessLogStore);
+        return result;
     }
 };
 
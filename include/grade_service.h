@@ -120,7 +120,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin", "teacher"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::STAFF)) {
             return errorResponse("Forbidden", "Admin or teacher only", 403);
         }
 
@@ -182,8 +182,7 @@ public:
             dataManager->getCurrentTimestamp(),
             dataManager->getCurrentTimestamp()
         };
-        grades.push_back(newGrade);
-        dataManager->saveGrades(grades);
+        dataManager->addGrade(newGrade);
 
         // 记录日志
         auto currentUser = authManager->getCurrentUser(token.substr(7));
@@ -203,7 +202,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin", "teacher"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::STAFF)) {
             return errorResponse("Forbidden", "Admin or teacher only", 403);
         }
 
@@ -224,18 +223,16 @@ public:
             return errorResponse("BadRequest", "Score must be between 0 and 100", 400);
         }
 
-        auto grades = dataManager->getGrades();
-        auto it = std::find_if(grades.begin(), grades.end(),
-            [&](const Grade& g) { return g.id == id; });
+        std::string now = dataManager->getCurrentTimestamp();
+        auto updated = dataManager->updateGrade(id, [&](Grade& grade) {
+            grade.score = score;
+            grade.updatedAt = now;
+        });
         
-        if (it == grades.end()) {
+        if (!updated.has_value()) {
             return errorResponse("NotFound", "Grade not found", 404);
         }
 
-        it->score = score;
-        it->updatedAt = dataManager->getCurrentTimestamp();
-        dataManager->saveGrades(grades);
-
         // 记录日志
         auto currentUser = authManager->getCurrentUser(token.substr(7));
         if (currentUser.has_value()) {
@@ -243,7 +240,7 @@ public:
                                "PUT /grades/" + id, "成绩管理");
         }
 
-        return jsonResponse(*it);
+        return jsonResponse(*updated);
     }
 
     // 删除成绩
@@ -254,21 +251,14 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin", "teacher"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::STAFF)) {
             return errorResponse("Forbidden", "Admin or teacher only", 403);
         }
 
-        auto grades = dataManager->getGrades();
-        auto it = std::find_if(grades.begin(), grades.end(),
-            [&](const Grade& g) { return g.id == id; });
-        
-        if (it == grades.end()) {
+        if (!dataManager->removeGrade(id)) {
             return errorResponse("NotFound", "Grade not found", 404);
         }
 
-        grades.erase(it);
-        dataManager->saveGrades(grades);
-
         // 记录日志
         auto currentUser = authManager->getCurrentUser(token.substr(7));
         if (currentUser.has_value()) {
@@ -388,7 +378,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin", "teacher"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::STAFF)) {
             return errorResponse("Forbidden", "Admin or teacher only", 403);
         }
 
@@ -538,7 +528,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin", "teacher"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::STAFF)) {
             return errorResponse("Forbidden", "Admin or teacher only", 403);
         }
 
@@ -0,0 +1,702 @@
+#ifndef GRADE_STATS_H
+#define GRADE_STATS_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "models.h"
+
+// 分数累计量：计数、总和、平方和、及格数与 0–100 每分一格的直方图，增删均为 O(1)
+// 最高/最低分与分位数由直方图得到，标准差由一、二阶矩得到，不必回看原始成绩
+struct ScoreStats {
+    static constexpr int MAX_SCORE = 100;
+    static constexpr int PASS_SCORE = 60;
+
+    uint32_t count = 0;
+    int64_t sum = 0;
+    int64_t sumSquares = 0;
+    uint32_t passCount = 0;
+    std::array<uint32_t, MAX_SCORE + 1> histogram{};
+
+    static int bin(int score) { return std::clamp(score, 0, MAX_SCORE); }
+
+    void add(int score) {
+        count++;
+        sum += score;
+        sumSquares += static_cast<int64_t>(score) * score;
+        if (score >= PASS_SCORE) passCount++;
+        histogram[bin(score)]++;
+    }
+
+    void remove(int score) {
+        count--;
+        sum -= score;
+        sumSquares -= static_cast<int64_t>(score) * score;
+        if (score >= PASS_SCORE) passCount--;
+        histogram[bin(score)]--;
+    }
+
+    void merge(const ScoreStats& other) {
+        count += other.count;
+        sum += other.sum;
+        sumSquares += other.sumSquares;
+        passCount += other.passCount;
+        for (size_t i = 0; i < histogram.size(); ++i) histogram[i] += other.histogram[i];
+    }
+
+    void subtract(const ScoreStats& other) {
+        count -= other.count;
+        sum -= other.sum;
+        sumSquares -= other.sumSquares;
+        passCount -= other.passCount;
+        for (size_t i = 0; i < histogram.size(); ++i) histogram[i] -= other.histogram[i];
+    }
+
+    bool empty() const { return count == 0; }
+    double average() const { return count > 0 ? static_cast<double>(sum) / count : 0.0; }
+    double passRate() const { return count > 0 ? static_cast<double>(passCount) / count * 100.0 : 0.0; }
+
+    int highest() const {
+        for (int s = MAX_SCORE; s >= 0; --s) {
+            if (histogram[s] > 0) return s;
+        }
+        return 0;
+    }
+
+    int lowest() const {
+        for (int s = 0; s <= MAX_SCORE; ++s) {
+            if (histogram[s] > 0) return s;
+        }
+        return 0;
+    }
+
+    // 总体标准差
+    double stddev() const {
+        if (count == 0) return 0.0;
+        double mean = average();
+        double variance = static_cast<double>(sumSquares) / count - mean * mean;
+        return variance > 0 ? std::sqrt(variance) : 0.0;
+    }
+
+    // 第 rank 小的成绩（从 0 开始），由累计直方图定位
+    int valueAt(uint32_t rank) const {
+        uint32_t seen = 0;
+        for (int s = 0; s <= MAX_SCORE; ++s) {
+            seen += histogram[s];
+            if (seen > rank) return s;
+        }
+        return MAX_SCORE;
+    }
+
+    // 分位数（p ∈ [0, 1]），相邻两名次之间线性插值，与排序后取值的结果一致
+    double quantile(double p) const {
+        if (count == 0) return 0.0;
+        double position = std::clamp(p, 0.0, 1.0) * (count - 1);
+        uint32_t lower = static_cast<uint32_t>(std::floor(position));
+        uint32_t upper = static_cast<uint32_t>(std::ceil(position));
+        int low = valueAt(lower);
+        int high = upper == lower ? low : valueAt(upper);
+        return low + (high - low) * (position - lower);
+    }
+
+    double median() const { return quantile(0.5); }
+
+    // 百分位等级：低于该分数的比例加上等于该分数比例的一半（百分比）
+    double percentileRank(int score) const {
+        if (count == 0) return 0.0;
+        uint32_t below = score > 0 ? countBetween(0, score - 1) : 0;
+        uint32_t equal = score >= 0 && score <= MAX_SCORE ? histogram[score] : 0;
+        return (below + equal / 2.0) / count * 100.0;
+    }
+
+    // [min, max] 内的成绩数，按直方图求和
+    uint32_t countBetween(int min, int max) const {
+        uint32_t n = 0;
+        for (int s = std::max(min, 0); s <= std::min(max, MAX_SCORE); ++s) n += histogram[s];
+        return n;
+    }
+};
+
+// 分数段（闭区间）
+struct ScoreRange {
+    int min = 0;
+    int max = ScoreStats::MAX_SCORE;
+
+    std::string label() const { return std::to_string(min) + "-" + std::to_string(max); }
+};
+
+// 分数段布局：由直方图按段求和，与数据量无关
+namespace ScoreBuckets {
+    // 默认五段（与早期接口一致）
+    inline std::vector<ScoreRange> defaults() {
+        return {{90, 100}, {80, 89}, {70, 79}, {60, 69}, {0, 59}};
+    }
+
+    // 十分位：90-100, 80-89, ..., 0-9
+    inline std::vector<ScoreRange> deciles() {
+        std::vector<ScoreRange> ranges;
+        for (int low = 90; low >= 0; low -= 10) ranges.push_back({low, low == 90 ? 100 : low + 9});
+        return ranges;
+    }
+
+    inline std::optional<int> parseScore(const std::string& text) {
+        if (text.empty() || text.size() > 3) return std::nullopt;
+        int value = 0;
+        for (char c : text) {
+            if (c < '0' || c > '9') return std::nullopt;
+            value = value * 10 + (c - '0');
+        }
+        if (value > ScoreStats::MAX_SCORE) return std::nullopt;
+        return value;
+    }
+
+    // 解析分数段参数（结果按分数从高到低排列）：
+    //   空串或 default  默认五段
+    //   deciles         十分位
+    //   60,70,80,90     分割点，划分为 0-59, 60-69, 70-79, 80-89, 90-100
+    //   0-59,60-84,85-100 显式区间
+    // 格式错误、分割点非递增或区间越界时返回 nullopt
+    inline std::optional<std::vector<ScoreRange>> parse(const std::string& spec) {
+        if (spec.empty() || spec == "default") return defaults();
+        if (spec == "deciles") return deciles();
+
+        std::vector<std::string> items;
+        size_t start = 0;
+        while (start <= spec.size()) {
+            size_t comma = spec.find(',', start);
+            if (comma == std::string::npos) comma = spec.size();
+            std::string item = spec.substr(start, comma - start);
+            item.erase(0, item.find_first_not_of(' '));
+            item.erase(item.find_last_not_of(' ') + 1);
+            items.push_back(item);
+            start = comma + 1;
+        }
+
+        std::vector<ScoreRange> ranges;
+        if (spec.find('-') != std::string::npos) {
+            for (const auto& item : items) {
+                size_t dash = item.find('-');
+                if (dash == std::string::npos) return std::nullopt;
+                auto min = parseScore(item.substr(0, dash));
+                auto max = parseScore(item.substr(dash + 1));
+                if (!min || !max || *min > *max) return std::nullopt;
+                ranges.push_back({*min, *max});
+            }
+        } else {
+            int low = 0;
+            for (const auto& item : items) {
+                auto cut = parseScore(item);
+                if (!cut || *cut <= low) return std::nullopt;
+                ranges.push_back({low, *cut - 1});
+                low = *cut;
+            }
+            ranges.push_back({low, ScoreStats::MAX_SCORE});
+        }
+        std::sort(ranges.begin(), ranges.end(),
+            [](const ScoreRange& a, const ScoreRange& b) { return a.min > b.min; });
+        return ranges;
+    }
+}
+
+// 成绩统计索引：全局、课程、班级、学生四种范围以及班级×课程二维立方体的累计量
+// DataManager 保存成绩/学生/课程时按新旧差异逐条增减，统计接口直接读取，无需扫描成绩文件
+// 每个课程/班级另记版本号（该范围的成绩或学生变化时递增），供统计结果缓存只失效受影响的范围
+// 另以列式保存全部成绩（uint8_t 分数列与课程/学生/班级编号列），累计量无法回答的组合筛选按掩码扫描分数列
+class GradeStatsIndex {
+public:
+    // 学生成绩概览中的一条成绩
+    struct GradeBrief {
+        std::string courseName;
+        int score = 0;
+    };
+
+    static constexpr uint32_t NO_KEY = UINT32_MAX;
+
+    // 列式成绩的只读视图，仅在 scanColumns 的回调内有效
+    struct ColumnsView {
+        const uint8_t* scores = nullptr;
+        const uint32_t* courses = nullptr;
+        const uint32_t* students = nullptr;
+        const uint32_t* classes = nullptr;
+        size_t rows = 0;
+        const std::vector<const std::string*>* studentIds = nullptr; // 学生编号 -> 学号
+        uint32_t courseKey = NO_KEY; // 课程筛选，NO_KEY 表示不限
+        uint32_t classKey = NO_KEY;  // 班级筛选，NO_KEY 表示不限
+
+        size_t studentCount() const { return studentIds->size(); }
+
+        // [begin, end) 行的选择掩码：学生在学生名单中且满足课程/班级筛选
+        void select(size_t begin, size_t end, uint8_t* mask) const {
+            for (size_t i = begin; i < end; ++i) {
+                mask[i - begin] = (classes[i] != NO_KEY) &
+                                  (courseKey == NO_KEY || courses[i] == courseKey) &
+                                  (classKey == NO_KEY || classes[i] == classKey);
+            }
+        }
+    };
+
+    // 班级×课程立方体中的一格
+    struct CubeCell {
+        std::string className;
+        std::string courseId;
+        ScoreStats stats;
+    };
+
+private:
+    struct Entry {
+        std::string studentId;
+        std::string courseId;
+        std::string courseName;
+        int score = 0;
+        uint32_t row = 0;   // 在分数列中的行号
+    };
+
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string, Entry> grades;                          // 成绩ID -> 成绩
+    std::unordered_map<std::string, std::vector<std::string>> studentGrades; // 学号 -> 成绩ID（文件顺序）
+    std::unordered_map<std::string, std::string> classOf;                   // 学号 -> 班级
+    std::unordered_map<std::string, size_t> classSize;                      // 班级 -> 学生数
+    std::vector<std::string> classOrder;                                    // 班级（按学生文件中首次出现的顺序）
+    std::unordered_map<std::string, std::unordered_map<std::string, uint32_t>> courseStudents; // 课程 -> 学号 -> 成绩数
+    size_t studentTotal = 0;
+    size_t courseTotal = 0;
+
+    // 列式成绩：同一行号对应同一条成绩，删除时用末行填补空位
+    std::vector<uint8_t> scoreColumn;
+    std::vector<uint32_t> courseColumn;
+    std::vector<uint32_t> studentColumn;
+    std::vector<uint32_t> classColumn;                                      // 学生不存在时为 NO_KEY
+    std::vector<const std::string*> rowGrade;                               // 行号 -> 成绩ID（指向 grades 的键）
+    std::unordered_map<std::string, uint32_t> courseKeys;                   // 课程ID -> 编号
+    std::unordered_map<std::string, uint32_t> studentKeys;                  // 学号 -> 编号
+    std::vector<const std::string*> studentIds;                             // 编号 -> 学号（指向 studentKeys 的键）
+    std::unordered_map<std::string, uint32_t> classKeys;                    // 班级 -> 编号
+
+    // 范围版本号：取自单调递增的时钟，重建后所有范围都不低于 rebuiltAt
+    uint64_t generation = 0;
+    uint64_t rebuiltAt = 0;
+    std::unordered_map<std::string, uint64_t> courseVersions;
+    std::unordered_map<std::string, uint64_t> classVersions;
+
+    ScoreStats overall;
+    std::unordered_map<std::string, ScoreStats> byCourse;
+    std::unordered_map<std::string, ScoreStats> byClass;
+    std::unordered_map<std::string, ScoreStats> byStudent;
+    std::unordered_map<std::string, std::unordered_map<std::string, ScoreStats>> byClassCourse; // 班级 -> 课程 -> 累计量
+
+    template<typename Map>
+    static std::optional<ScoreStats> find(const Map& map, const std::string& key) {
+        auto it = map.find(key);
+        if (it == map.end() || it->second.empty()) return std::nullopt;
+        return it->second;
+    }
+
+    static uint32_t intern(std::unordered_map<std::string, uint32_t>& keys, const std::string& name) {
+        return keys.try_emplace(name, static_cast<uint32_t>(keys.size())).first->second;
+    }
+
+    static uint32_t keyOf(const std::unordered_map<std::string, uint32_t>& keys, const std::string& name) {
+        auto it = keys.find(name);
+        return it == keys.end() ? NO_KEY : it->second;
+    }
+
+    void touchLocked(std::unordered_map<std::string, uint64_t>& versions, const std::string& key) {
+        versions[key] = ++generation;
+    }
+
+    uint64_t versionOf(const std::unordered_map<std::string, uint64_t>& versions, const std::string& key) const {
+        auto it = versions.find(key);
+        return it == versions.end() ? rebuiltAt : std::max(it->second, rebuiltAt);
+    }
+
+    uint32_t internStudent(const std::string& studentId) {
+        auto [it, inserted] = studentKeys.try_emplace(studentId, static_cast<uint32_t>(studentKeys.size()));
+        if (inserted) studentIds.push_back(&it->first);
+        return it->second;
+    }
+
+    uint32_t classKeyOf(const std::string& studentId) {
+        auto cls = classOf.find(studentId);
+        return cls == classOf.end() ? NO_KEY : intern(classKeys, cls->second);
+    }
+
+    void addLocked(const std::string& id, const Grade& grade) {
+        uint32_t row = static_cast<uint32_t>(scoreColumn.size());
+        auto entry = grades.insert_or_assign(id, Entry{grade.studentId, grade.courseId, grade.courseName, grade.score, row}).first;
+        scoreColumn.push_back(static_cast<uint8_t>(ScoreStats::bin(grade.score)));
+        courseColumn.push_back(intern(courseKeys, grade.courseId));
+        studentColumn.push_back(internStudent(grade.studentId));
+        classColumn.push_back(classKeyOf(grade.studentId));
+        rowGrade.push_back(&entry->first);
+
+        studentGrades[grade.studentId].push_back(id);
+        courseStudents[grade.courseId][grade.studentId]++;
+        overall.add(grade.score);
+        byCourse[grade.courseId].add(grade.score);
+        byStudent[grade.studentId].add(grade.score);
+        touchLocked(courseVersions, grade.courseId);
+        auto cls = classOf.find(grade.studentId);
+        if (cls != classOf.end()) {
+            byClass[cls->second].add(grade.score);
+            byClassCourse[cls->second][grade.courseId].add(grade.score);
+            touchLocked(classVersions, cls->second);
+        }
+    }
+
+    // 删除一行：末行移入空位
+    void removeRowLocked(uint32_t row) {
+        uint32_t last = static_cast<uint32_t>(scoreColumn.size() - 1);
+        if (row != last) {
+            scoreColumn[row] = scoreColumn[last];
+            courseColumn[row] = courseColumn[last];
+            studentColumn[row] = studentColumn[last];
+            classColumn[row] = classColumn[last];
+            rowGrade[row] = rowGrade[last];
+            grades.at(*rowGrade[row]).row = row;
+        }
+        scoreColumn.pop_back();
+        courseColumn.pop_back();
+        studentColumn.pop_back();
+        classColumn.pop_back();
+        rowGrade.pop_back();
+    }
+
+    void removeLocked(const std::string& id) {
+        auto it = grades.find(id);
+        if (it == grades.end()) return;
+        const Entry& entry = it->second;
+        auto& ids = studentGrades[entry.studentId];
+        ids.erase(std::find(ids.begin(), ids.end(), id));
+        if (ids.empty()) studentGrades.erase(entry.studentId);
+        auto& students = courseStudents[entry.courseId];
+        if (--students[entry.studentId] == 0) students.erase(entry.studentId);
+        overall.remove(entry.score);
+        byCourse[entry.courseId].remove(entry.score);
+        byStudent[entry.studentId].remove(entry.score);
+        touchLocked(courseVersions, entry.courseId);
+        auto cls = classOf.find(entry.studentId);
+        if (cls != classOf.end()) {
+            byClass[cls->second].remove(entry.score);
+            byClassCourse[cls->second][entry.courseId].remove(entry.score);
+            touchLocked(classVersions, cls->second);
+        }
+        uint32_t row = entry.row;
+        grades.erase(it);
+        removeRowLocked(row);
+    }
+
+    // 新增或修改一条成绩，O(1)（另加该学生成绩数的顺序维护）
+    void upsertLocked(const Grade& grade) {
+        auto it = grades.find(grade.id);
+        if (it == grades.end()) {
+            addLocked(grade.id, grade);
+            return;
+        }
+        const Entry& entry = it->second;
+        if (entry.score == grade.score && entry.studentId == grade.studentId && entry.courseId == grade.courseId) {
+            it->second.courseName = grade.courseName;
+            return;
+        }
+        // 修改成绩：在原位置替换，保持学生成绩的文件顺序
+        auto& ids = studentGrades[entry.studentId];
+        size_t index = std::find(ids.begin(), ids.end(), grade.id) - ids.begin();
+        bool sameStudent = entry.studentId == grade.studentId;
+        removeLocked(grade.id);
+        addLocked(grade.id, grade);
+        if (sameStudent) {
+            auto& order = studentGrades[grade.studentId];
+            if (index < order.size() - 1) {
+                order.pop_back();
+                order.insert(order.begin() + index, grade.id);
+            }
+        }
+    }
+
+    void applyGradesLocked(const std::vector<Grade>& next) {
+        std::unordered_set<std::string> seen;
+        seen.reserve(next.size());
+        for (const auto& grade : next) {
+            seen.insert(grade.id);
+            upsertLocked(grade);
+        }
+        std::vector<std::string> removed;
+        for (const auto& [id, entry] : grades) {
+            if (seen.count(id) == 0) removed.push_back(id);
+        }
+        for (const auto& id : removed) removeLocked(id);
+    }
+
+    // 把学生的全部成绩计入（或移出）某班级在立方体中的各课程格
+    void moveCubeLocked(const std::string& studentId, const std::string& className, bool add) {
+        auto ids = studentGrades.find(studentId);
+        if (ids == studentGrades.end()) return;
+        auto& row = byClassCourse[className];
+        for (const auto& id : ids->second) {
+            const Entry& entry = grades.at(id);
+            if (add) {
+                row[entry.courseId].add(entry.score);
+            } else {
+                row[entry.courseId].remove(entry.score);
+            }
+        }
+    }
+
+    // 学生换班、新增或删除时，把其全部成绩的累计量整体移到新班级
+    void applyStudentsLocked(const std::vector<Student>& students) {
+        std::unordered_map<std::string, std::string> next;
+        next.reserve(students.size());
+        classSize.clear();
+        classOrder.clear();
+        for (const auto& student : students) {
+            next[student.studentId] = student.className;
+            if (classSize[student.className]++ == 0) classOrder.push_back(student.className);
+        }
+        std::vector<std::string> moved;
+        for (const auto& [studentId, className] : classOf) {
+            auto it = next.find(studentId);
+            if (it != next.end() && it->second == className) continue;
+            if (it == next.end()) moved.push_back(studentId);
+            touchLocked(classVersions, className);
+            auto stats = byStudent.find(studentId);
+            if (stats != byStudent.end()) byClass[className].subtract(stats->second);
+            moveCubeLocked(studentId, className, false);
+        }
+        for (const auto& [studentId, className] : next) {
+            auto it = classOf.find(studentId);
+            if (it != classOf.end() && it->second == className) continue;
+            moved.push_back(studentId);
+            touchLocked(classVersions, className);
+            auto stats = byStudent.find(studentId);
+            if (stats != byStudent.end()) byClass[className].merge(stats->second);
+            moveCubeLocked(studentId, className, true);
+        }
+        for (auto it = byClass.begin(); it != byClass.end();) {
+            if (it->second.empty() && classSize.count(it->first) == 0) {
+                byClassCourse.erase(it->first);
+                it = byClass.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        classOf.swap(next);
+        studentTotal = students.size();
+
+        // 班级列跟随学生的新班级
+        for (const auto& studentId : moved) {
+            auto ids = studentGrades.find(studentId);
+            if (ids == studentGrades.end()) continue;
+            uint32_t classKey = classKeyOf(studentId);
+            for (const auto& id : ids->second) classColumn[grades.at(id).row] = classKey;
+        }
+    }
+
+public:
+    // 从完整数据重建（启动与恢复备份时）
+    void rebuild(const std::vector<Grade>& allGrades, const std::vector<Student>& students,
+                 const std::vector<Course>& courses) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        rebuiltAt = ++generation;
+        grades.clear();
+        studentGrades.clear();
+        classOf.clear();
+        courseStudents.clear();
+        overall = ScoreStats{};
+        byCourse.clear();
+        byClass.clear();
+        byStudent.clear();
+        byClassCourse.clear();
+        scoreColumn.clear();
+        courseColumn.clear();
+        studentColumn.clear();
+        classColumn.clear();
+        rowGrade.clear();
+        courseKeys.clear();
+        studentKeys.clear();
+        studentIds.clear();
+        classKeys.clear();
+        applyStudentsLocked(students);
+        for (const auto& grade : allGrades) {
+            if (grades.count(grade.id) == 0) addLocked(grade.id, grade);
+        }
+        courseTotal = courses.size();
+    }
+
+    // 按完整成绩列表比对差异（批量导入等一次改动多条成绩时）
+    void applyGrades(const std::vector<Grade>& next) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        applyGradesLocked(next);
+    }
+
+    // 新增或修改一条成绩
+    void putGrade(const Grade& grade) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        upsertLocked(grade);
+    }
+
+    // 删除一条成绩（不存在时忽略）
+    void removeGrade(const std::string& id) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        removeLocked(id);
+    }
+
+    void applyStudents(const std::vector<Student>& students) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        applyStudentsLocked(students);
+    }
+
+    void applyCourses(const std::vector<Course>& courses) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        courseTotal = courses.size();
+    }
+
+    ScoreStats overallStats() const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return overall;
+    }
+
+    std::optional<ScoreStats> courseStats(const std::string& courseId) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return find(byCourse, courseId);
+    }
+
+    std::optional<ScoreStats> classStats(const std::string& className) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return find(byClass, className);
+    }
+
+    std::optional<ScoreStats> studentStats(const std::string& studentId) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return find(byStudent, studentId);
+    }
+
+    // 某班级某课程的累计量
+    std::optional<ScoreStats> cellStats(const std::string& className, const std::string& courseId) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto row = byClassCourse.find(className);
+        if (row == byClassCourse.end()) return std::nullopt;
+        return find(row->second, courseId);
+    }
+
+    // 立方体切片（空串表示不限）：一个班级的各课程、一门课程的各班级或全部非空格
+    std::vector<CubeCell> cube(const std::string& className, const std::string& courseId) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        std::vector<CubeCell> cells;
+        auto collect = [&](const std::string& cls, const std::unordered_map<std::string, ScoreStats>& row) {
+            if (!courseId.empty()) {
+                auto cell = row.find(courseId);
+                if (cell != row.end() && !cell->second.empty()) cells.push_back({cls, courseId, cell->second});
+                return;
+            }
+            for (const auto& [course, stats] : row) {
+                if (!stats.empty()) cells.push_back({cls, course, stats});
+            }
+        };
+        if (!className.empty()) {
+            auto row = byClassCourse.find(className);
+            if (row != byClassCourse.end()) collect(className, row->second);
+        } else {
+            for (const auto& [cls, row] : byClassCourse) collect(cls, row);
+        }
+        return cells;
+    }
+
+    // 课程/班级的版本号：该范围内成绩增删改或班级成员变化后增大
+    uint64_t courseVersion(const std::string& courseId) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return versionOf(courseVersions, courseId);
+    }
+
+    uint64_t classVersion(const std::string& className) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return versionOf(classVersions, className);
+    }
+
+    // 持读锁扫描列式成绩：fn(const ColumnsView&) 内可并行读取各列，但不得回调本索引
+    // 筛选的课程或班级不存在时视图为空
+    template<typename F>
+    void scanColumns(const std::string& courseId, const std::string& className, F&& fn) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        ColumnsView view;
+        view.studentIds = &studentIds;
+        view.courseKey = courseId.empty() ? NO_KEY : keyOf(courseKeys, courseId);
+        view.classKey = className.empty() ? NO_KEY : keyOf(classKeys, className);
+        bool unknown = (!courseId.empty() && view.courseKey == NO_KEY) || (!className.empty() && view.classKey == NO_KEY);
+        if (!unknown) {
+            view.scores = scoreColumn.data();
+            view.courses = courseColumn.data();
+            view.students = studentColumn.data();
+            view.classes = classColumn.data();
+            view.rows = scoreColumn.size();
+        }
+        fn(static_cast<const ColumnsView&>(view));
+    }
+
+    // 学生所有成绩中的最高分
+    std::optional<int> studentHighest(const std::string& studentId) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = byStudent.find(studentId);
+        if (it == byStudent.end() || it->second.empty()) return std::nullopt;
+        return it->second.highest();
+    }
+
+    // 遍历有成绩的学生（持读锁，fn 内不得回调本索引）
+    template<typename F>
+    void forEachStudent(F&& fn) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        for (const auto& [studentId, stats] : byStudent) {
+            if (!stats.empty()) fn(studentId, stats);
+        }
+    }
+
+    size_t totalStudents() const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return studentTotal;
+    }
+
+    size_t totalCourses() const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return courseTotal;
+    }
+
+    // 班级学生数（按学生文件）
+    size_t classStudentCount(const std::string& className) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = classSize.find(className);
+        return it == classSize.end() ? 0 : it->second;
+    }
+
+    // 有该课程成绩的不同学生数
+    size_t courseStudentCount(const std::string& courseId) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = courseStudents.find(courseId);
+        return it == courseStudents.end() ? 0 : it->second.size();
+    }
+
+    std::vector<std::string> classes() const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return classOrder;
+    }
+
+    // 学生最近的若干条成绩（按文件顺序从后往前）
+    std::vector<GradeBrief> recentGrades(const std::string& studentId, size_t limit) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        std::vector<GradeBrief> result;
+        auto it = studentGrades.find(studentId);
+        if (it == studentGrades.end()) return result;
+        for (auto id = it->second.rbegin(); id != it->second.rend() && result.size() < limit; ++id) {
+            const Entry& entry = grades.at(*id);
+            result.push_back({entry.courseName, entry.score});
+        }
+        return result;
+    }
+};
+
+#endif // GRADE_STATS_H
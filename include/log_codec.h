@@ -0,0 +1,378 @@
+#ifndef LOG_CODEC_H
+#define LOG_CODEC_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <iterator>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <optional>
+#include <ctime>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include "models.h"
+
+namespace fs = std::filesystem;
+
+// 日志二进制编码基础操作：无符号 varint 与带长度前缀的字符串
+namespace LogBinary {
+    inline void putVarint(std::string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    inline bool getVarint(const char*& p, const char* end, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && p < end; shift += 7) {
+            uint8_t byte = static_cast<uint8_t>(*p++);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) return true;
+        }
+        return false;
+    }
+
+    inline void putString(std::string& out, const std::string& value) {
+        putVarint(out, value.size());
+        out.append(value);
+    }
+
+    inline bool getString(const char*& p, const char* end, std::string& value) {
+        uint64_t len;
+        if (!getVarint(p, end, len) || len > static_cast<uint64_t>(end - p)) return false;
+        value.assign(p, static_cast<size_t>(len));
+        p += len;
+        return true;
+    }
+
+    // "YYYY-MM-DD HH:MM:SS"（本地时间）与毫秒时间戳互转；无法精确还原时返回 nullopt
+    inline std::optional<int64_t> toEpochMillis(const std::string& text) {
+        std::tm tm{};
+        if (text.size() != 19 ||
+            std::sscanf(text.c_str(), "%4d-%2d-%2d %2d:%2d:%2d",
+                        &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6) {
+            return std::nullopt;
+        }
+        tm.tm_year -= 1900;
+        tm.tm_mon -= 1;
+        tm.tm_isdst = -1;
+        std::time_t tt = std::mktime(&tm);
+        if (tt == static_cast<std::time_t>(-1)) return std::nullopt;
+        return static_cast<int64_t>(tt) * 1000;
+    }
+
+    inline std::string fromEpochMillis(int64_t millis) {
+        std::time_t tt = static_cast<std::time_t>(millis / 1000);
+        std::tm tm{};
+    #ifdef _WIN32
+        localtime_s(&tm, &tt);
+    #else
+        localtime_r(&tt, &tm);
+    #endif
+        char buf[32];
+        std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+        return std::string(buf);
+    }
+
+    // 形如 "<秒>_<随机数>" 的ID（DataManager::generateId）拆成两个整数；无法精确还原时返回 false
+    inline bool splitId(const std::string& id, uint64_t& first, uint64_t& second) {
+        size_t sep = id.find('_');
+        if (sep == std::string::npos || sep == 0 || sep + 1 >= id.size() || sep > 19 || id.size() - sep - 1 > 19) {
+            return false;
+        }
+        for (size_t i = 0; i < id.size(); ++i) {
+            if (i != sep && (id[i] < '0' || id[i] > '9')) return false;
+        }
+        first = std::stoull(id.substr(0, sep));
+        second = std::stoull(id.substr(sep + 1));
+        return std::to_string(first) + "_" + std::to_string(second) == id;
+    }
+}
+
+// 日志字符串字典：重复出现的模块、操作、用户等字段只存一次，记录中以编号引用
+// 字典文件只追加（每项为带长度前缀的字符串，编号即写入顺序），新项先于引用它的记录落盘
+// 超过容量上限后不再收录新字符串，由编码方直接内联
+class LogDictionary {
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+private:
+    static constexpr size_t MAX_ENTRIES = 65536;
+
+    std::string path;
+    mutable std::shared_mutex mutex;
+    std::vector<std::string> entries;
+    std::unordered_map<std::string, uint32_t> ids;
+    std::ofstream out;
+
+public:
+    // 所在目录创建后再调用 load()
+    explicit LogDictionary(const std::string& filePath) : path(filePath) {}
+
+    const std::string& filePath() const { return path; }
+
+    // 从字典文件重新加载（恢复备份后调用），末尾不完整的项会被截掉
+    void load() {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        if (out.is_open()) out.close();
+        entries.clear();
+        ids.clear();
+
+        std::string data;
+        {
+            std::ifstream file(path, std::ios::binary);
+            if (file.is_open()) data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        const char* p = data.data();
+        const char* end = p + data.size();
+        const char* valid = p;
+        std::string value;
+        while (p < end && LogBinary::getString(p, end, value)) {
+            ids.emplace(value, static_cast<uint32_t>(entries.size()));
+            entries.push_back(value);
+            valid = p;
+        }
+        if (valid != end) {
+            std::error_code ec;
+            fs::resize_file(path, static_cast<uintmax_t>(valid - data.data()), ec);
+        }
+        out.open(path, std::ios::app | std::ios::binary);
+    }
+
+    // 删除字典文件并清空（内容整体替换时调用）
+    void clear() {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        if (out.is_open()) out.close();
+        entries.clear();
+        ids.clear();
+        std::error_code ec;
+        fs::remove(path, ec);
+        out.open(path, std::ios::app | std::ios::binary);
+    }
+
+    // 取字符串编号，未收录时追加到字典；字典已满时返回 NONE（仅写线程调用）
+    uint32_t intern(const std::string& value) {
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            auto it = ids.find(value);
+            if (it != ids.end()) return it->second;
+            if (entries.size() >= MAX_ENTRIES) return NONE;
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        auto it = ids.find(value);
+        if (it != ids.end()) return it->second;
+        std::string frame;
+        LogBinary::putString(frame, value);
+        out.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+        out.flush();
+        uint32_t id = static_cast<uint32_t>(entries.size());
+        ids.emplace(value, id);
+        entries.push_back(value);
+        return id;
+    }
+
+    bool lookup(uint32_t id, std::string& value) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        if (id >= entries.size()) return false;
+        value = entries[id];
+        return true;
+    }
+
+    // 字段引用：0 表示随后内联字符串，否则为字典编号+1
+    void putRef(std::string& buf, const std::string& value) {
+        uint32_t id = intern(value);
+        if (id == NONE) {
+            LogBinary::putVarint(buf, 0);
+            LogBinary::putString(buf, value);
+        } else {
+            LogBinary::putVarint(buf, static_cast<uint64_t>(id) + 1);
+        }
+    }
+
+    bool getRef(const char*& p, const char* end, std::string& value) const {
+        uint64_t ref;
+        if (!LogBinary::getVarint(p, end, ref)) return false;
+        if (ref == 0) return LogBinary::getString(p, end, value);
+        return ref - 1 < NONE && lookup(static_cast<uint32_t>(ref - 1), value);
+    }
+};
+
+// 日志记录编解码：LogCodec<T>::encode 追加一条记录的负载，decode 还原为原结构
+// 公共字段：标志位 + ID（可拆分时存两个整数）+ ... + 时间（毫秒时间戳，无法精确还原时存原文）
+template<typename T>
+struct LogCodec;
+
+namespace LogCodecDetail {
+    enum Flags : uint8_t {
+        HAS_IP = 1 << 0,
+        COMPACT_ID = 1 << 1,
+        RAW_TIME = 1 << 2
+    };
+
+    inline uint8_t flagsFor(const std::string& id, const std::optional<std::string>& ip,
+                            const std::string& createdAt, uint64_t& idFirst, uint64_t& idSecond,
+                            std::optional<int64_t>& millis) {
+        uint8_t flags = 0;
+        if (ip.has_value()) flags |= HAS_IP;
+        if (LogBinary::splitId(id, idFirst, idSecond)) flags |= COMPACT_ID;
+        millis = LogBinary::toEpochMillis(createdAt);
+        if (!millis.has_value() || LogBinary::fromEpochMillis(*millis) != createdAt) flags |= RAW_TIME;
+        return flags;
+    }
+
+    inline void putId(std::string& buf, uint8_t flags, const std::string& id, uint64_t first, uint64_t second) {
+        if (flags & COMPACT_ID) {
+            LogBinary::putVarint(buf, first);
+            LogBinary::putVarint(buf, second);
+        } else {
+            LogBinary::putString(buf, id);
+        }
+    }
+
+    inline bool getId(const char*& p, const char* end, uint8_t flags, std::string& id) {
+        if (!(flags & COMPACT_ID)) return LogBinary::getString(p, end, id);
+        uint64_t first, second;
+        if (!LogBinary::getVarint(p, end, first) || !LogBinary::getVarint(p, end, second)) return false;
+        id = std::to_string(first) + "_" + std::to_string(second);
+        return true;
+    }
+
+    inline void putTime(std::string& buf, uint8_t flags, const std::string& createdAt, const std::optional<int64_t>& millis) {
+        if (flags & RAW_TIME) {
+            LogBinary::putString(buf, createdAt);
+        } else {
+            LogBinary::putVarint(buf, static_cast<uint64_t>(*millis));
+        }
+    }
+
+    inline bool getTime(const char*& p, const char* end, uint8_t flags, std::string& createdAt) {
+        if (flags & RAW_TIME) return LogBinary::getString(p, end, createdAt);
+        uint64_t millis;
+        if (!LogBinary::getVarint(p, end, millis)) return false;
+        createdAt = LogBinary::fromEpochMillis(static_cast<int64_t>(millis));
+        return true;
+    }
+}
+
+template<>
+struct LogCodec<OperationLog> {
+    static void encode(const OperationLog& log, LogDictionary& dict, std::string& buf) {
+        using namespace LogCodecDetail;
+        uint64_t idFirst = 0, idSecond = 0;
+        std::optional<int64_t> millis;
+        uint8_t flags = flagsFor(log.id, log.ip, log.createdAt, idFirst, idSecond, millis);
+        buf.push_back(static_cast<char>(flags));
+        putId(buf, flags, log.id, idFirst, idSecond);
+        dict.putRef(buf, log.userId);
+        dict.putRef(buf, log.username);
+        dict.putRef(buf, log.action);
+        dict.putRef(buf, log.module);
+        if (flags & HAS_IP) dict.putRef(buf, *log.ip);
+        putTime(buf, flags, log.createdAt, millis);
+    }
+
+    static bool decode(const char* p, const char* end, const LogDictionary& dict, OperationLog& log) {
+        using namespace LogCodecDetail;
+        if (p >= end) return false;
+        uint8_t flags = static_cast<uint8_t>(*p++);
+        if (!getId(p, end, flags, log.id)) return false;
+        if (!dict.getRef(p, end, log.userId) || !dict.getRef(p, end, log.username) ||
+            !dict.getRef(p, end, log.action) || !dict.getRef(p, end, log.module)) {
+            return false;
+        }
+        log.ip.reset();
+        if (flags & HAS_IP) {
+            std::string ip;
+            if (!dict.getRef(p, end, ip)) return false;
+            log.ip = ip;
+        }
+        return getTime(p, end, flags, log.createdAt);
+    }
+};
+
+template<>
+struct LogCodec<SystemLog> {
+    static void encode(const SystemLog& log, LogDictionary& dict, std::string& buf) {
+        using namespace LogCodecDetail;
+        uint64_t idFirst = 0, idSecond = 0;
+        std::optional<int64_t> millis;
+        uint8_t flags = flagsFor(log.id, log.ip, log.createdAt, idFirst, idSecond, millis);
+        buf.push_back(static_cast<char>(flags));
+        putId(buf, flags, log.id, idFirst, idSecond);
+        dict.putRef(buf, log.level);
+        dict.putRef(buf, log.module);
+        LogBinary::putString(buf, log.message); // 消息为自由文本，不进字典
+        if (flags & HAS_IP) dict.putRef(buf, *log.ip);
+        putTime(buf, flags, log.createdAt, millis);
+    }
+
+    static bool decode(const char* p, const char* end, const LogDictionary& dict, SystemLog& log) {
+        using namespace LogCodecDetail;
+        if (p >= end) return false;
+        uint8_t flags = static_cast<uint8_t>(*p++);
+        if (!getId(p, end, flags, log.id)) return false;
+        if (!dict.getRef(p, end, log.level) || !dict.getRef(p, end, log.module) ||
+            !LogBinary::getString(p, end, log.message)) {
+            return false;
+        }
+        log.ip.reset();
+        if (flags & HAS_IP) {
+            std::string ip;
+            if (!dict.getRef(p, end, ip)) return false;
+            log.ip = ip;
+        }
+        return getTime(p, end, flags, log.createdAt);
+    }
+};
+
+template<>
+struct LogCodec<AccessLog> {
+    static void encode(const AccessLog& log, LogDictionary& dict, std::string& buf) {
+        using namespace LogCodecDetail;
+        uint64_t unusedFirst = 0, unusedSecond = 0;
+        std::optional<int64_t> millis;
+        uint8_t flags = flagsFor("", log.ip, log.createdAt, unusedFirst, unusedSecond, millis);
+        buf.push_back(static_cast<char>(flags));
+        dict.putRef(buf, log.method);
+        dict.putRef(buf, log.route);
+        LogBinary::putVarint(buf, static_cast<uint64_t>(log.status));
+        LogBinary::putVarint(buf, log.bytes);
+        for (int64_t us : {log.totalUs, log.authUs, log.dataUs, log.computeUs, log.serializeUs, log.logUs}) {
+            LogBinary::putVarint(buf, static_cast<uint64_t>(us < 0 ? 0 : us));
+        }
+        if (flags & HAS_IP) dict.putRef(buf, *log.ip);
+        putTime(buf, flags, log.createdAt, millis);
+    }
+
+    static bool decode(const char* p, const char* end, const LogDictionary& dict, AccessLog& log) {
+        using namespace LogCodecDetail;
+        if (p >= end) return false;
+        uint8_t flags = static_cast<uint8_t>(*p++);
+        uint64_t status;
+        if (!dict.getRef(p, end, log.method) || !dict.getRef(p, end, log.route) ||
+            !LogBinary::getVarint(p, end, status) || !LogBinary::getVarint(p, end, log.bytes)) {
+            return false;
+        }
+        log.status = static_cast<int>(status);
+        for (int64_t* us : {&log.totalUs, &log.authUs, &log.dataUs, &log.computeUs, &log.serializeUs, &log.logUs}) {
+            uint64_t value;
+            if (!LogBinary::getVarint(p, end, value)) return false;
+            *us = static_cast<int64_t>(value);
+        }
+        log.ip.reset();
+        if (flags & HAS_IP) {
+            std::string ip;
+            if (!dict.getRef(p, end, ip)) return false;
+            log.ip = ip;
+        }
+        return getTime(p, end, flags, log.createdAt);
+    }
+};
+
+#endif // LOG_CODEC_H
@@ -0,0 +1,112 @@
+#ifndef LOG_EXPORT_H
+#define LOG_EXPORT_H
+
+#include <string>
+#include <optional>
+#include <ostream>
+#include <cctype>
+#include <nlohmann/json.hpp>
+#include "models.h"
+
+using json = nlohmann::json;
+
+// 日志时间范围（闭区间，格式同 createdAt：YYYY-MM-DD HH:MM:SS），空串表示不限
+struct LogTimeRange {
+    std::string from;
+    std::string to;
+
+    // 解析查询参数：支持 YYYY-MM-DD、YYYY-MM-DD HH:MM:SS 与 YYYY-MM-DDTHH:MM:SS[Z]
+    // 只给日期时，起始取当天 00:00:00，结束取当天 23:59:59；格式错误返回 nullopt
+    static std::optional<LogTimeRange> parse(const std::string& start, const std::string& end) {
+        LogTimeRange range;
+        if (!normalize(start, "00:00:00", range.from)) return std::nullopt;
+        if (!normalize(end, "23:59:59", range.to)) return std::nullopt;
+        if (!range.from.empty() && !range.to.empty() && range.from > range.to) return std::nullopt;
+        return range;
+    }
+
+    bool contains(const std::string& createdAt) const {
+        if (!from.empty() && createdAt < from) return false;
+        if (!to.empty() && createdAt > to) return false;
+        return true;
+    }
+
+    // 用于按段日期剪枝
+    std::string fromDay() const { return from.empty() ? "" : from.substr(0, 10); }
+    std::string toDay() const { return to.empty() ? "" : to.substr(0, 10); }
+
+private:
+    static bool normalize(std::string text, const std::string& defaultTime, std::string& out) {
+        out.clear();
+        if (text.empty()) return true;
+        if (text.back() == 'Z') text.pop_back();
+        if (text.size() > 10 && text[10] == 'T') text[10] = ' ';
+        if (text.size() == 10) text += " " + defaultTime;
+        if (text.size() != 19) return false;
+        for (size_t i = 0; i < text.size(); ++i) {
+            char expected = (i == 4 || i == 7) ? '-' : (i == 10) ? ' ' : (i == 13 || i == 16) ? ':' : '0';
+            if (expected == '0') {
+                if (!std::isdigit(static_cast<unsigned char>(text[i]))) return false;
+            } else if (text[i] != expected) {
+                return false;
+            }
+        }
+        out = text;
+        return true;
+    }
+};
+
+// 日志导出格式：逐条写出，不在内存中累积
+namespace LogExport {
+    // CSV 字段转义（含逗号、引号或换行时加引号）
+    inline std::string csvField(const std::string& value) {
+        if (value.find_first_of(",\"\r\n") == std::string::npos) return value;
+        std::string escaped = "\"";
+        for (char c : value) {
+            if (c == '"') escaped += '"';
+            escaped += c;
+        }
+        escaped += '"';
+        return escaped;
+    }
+
+    inline void writeCsvHeader(std::ostream& out, const SystemLog&) {
+        out << "id,level,message,module,ip,createdAt\n";
+    }
+
+    inline void writeCsvHeader(std::ostream& out, const OperationLog&) {
+        out << "id,userId,username,action,module,ip,createdAt\n";
+    }
+
+    inline void writeCsvHeader(std::ostream& out, const AccessLog&) {
+        out << "method,route,status,bytes,totalUs,authUs,dataUs,computeUs,serializeUs,logUs,ip,createdAt\n";
+    }
+
+    inline void writeCsv(std::ostream& out, const SystemLog& log, const std::string& createdAt) {
+        out << csvField(log.id) << ',' << csvField(log.level) << ',' << csvField(log.message) << ','
+            << csvField(log.module) << ',' << csvField(log.ip.value_or("")) << ',' << csvField(createdAt) << '\n';
+    }
+
+    inline void writeCsv(std::ostream& out, const OperationLog& log, const std::string& createdAt) {
+        out << csvField(log.id) << ',' << csvField(log.userId) << ',' << csvField(log.username) << ','
+            << csvField(log.action) << ',' << csvField(log.module) << ',' << csvField(log.ip.value_or("")) << ','
+            << csvField(createdAt) << '\n';
+    }
+
+    inline void writeCsv(std::ostream& out, const AccessLog& log, const std::string& createdAt) {
+        out << csvField(log.method) << ',' << csvField(log.route) << ',' << log.status << ',' << log.bytes << ','
+            << log.totalUs << ',' << log.authUs << ',' << log.dataUs << ',' << log.computeUs << ','
+            << log.serializeUs << ',' << log.logUs << ',' << csvField(log.ip.value_or("")) << ','
+            << csvField(createdAt) << '\n';
+    }
+
+    template<typename T>
+    void writeNdjson(std::ostream& out, const T& log, const std::string& createdAt) {
+        json j = log;
+        j["createdAt"] = createdAt;
+        if (!j.contains("ip")) j["ip"] = "";
+        out << j.dump() << '\n';
+    }
+}
+
+#endif // LOG_EXPORT_H
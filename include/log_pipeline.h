@@ -0,0 +1,156 @@
+#ifndef LOG_PIPELINE_H
+#define LOG_PIPELINE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <variant>
+#include <vector>
+#include "models.h"
+#include "data_manager.h"
+#include "mpsc_ring_buffer.h"
+
+// 异步日志管道：请求线程以 O(1) 写入无锁环形队列，单个后台线程批量落盘
+class LogPipeline {
+public:
+    using Record = std::variant<OperationLog, SystemLog, AccessLog>;
+    // 定时日志来源：写线程每轮（空闲时每个 FLUSH_INTERVAL）调用一次，返回的日志直接落盘
+    // 在写线程中运行，不得调用 submit()（队列满时会等待写线程自身）
+    using PeriodicSource = std::function<std::vector<OperationLog>()>;
+
+private:
+    static constexpr size_t BATCH_SIZE = 4096;
+    static constexpr std::chrono::milliseconds FLUSH_INTERVAL{100};
+
+    DataManager* dataManager;
+    MpscRingBuffer<Record> ring;
+    std::thread writer;
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeCv;     // 唤醒写线程
+    std::condition_variable flushedCv;  // 通知 flush() 等待者
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> flushRequested{false};
+    std::atomic<uint64_t> writtenCount{0};
+
+    std::mutex sourceMutex;
+    PeriodicSource periodicSource;
+
+    void wakeWriter() {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        wakeCv.notify_one();
+    }
+
+    void push(Record record) {
+        // 队列满时让出CPU并唤醒写线程，直到有空位（不丢日志）
+        while (!ring.tryPush(record)) {
+            wakeWriter();
+            std::this_thread::yield();
+        }
+    }
+
+    // 取出最多一批记录并写入磁盘，返回写入条数
+    size_t drainBatch() {
+        std::vector<OperationLog> opLogs;
+        std::vector<SystemLog> sysLogs;
+        std::vector<AccessLog> accessLogs;
+        Record record;
+        size_t count = 0;
+        while (count < BATCH_SIZE && ring.tryPop(record)) {
+            if (auto* op = std::get_if<OperationLog>(&record)) {
+                opLogs.push_back(std::move(*op));
+            } else if (auto* sys = std::get_if<SystemLog>(&record)) {
+                sysLogs.push_back(std::move(*sys));
+            } else {
+                accessLogs.push_back(std::move(std::get<AccessLog>(record)));
+            }
+            count++;
+        }
+        if (count == 0) return 0;
+
+        try {
+            if (!opLogs.empty()) dataManager->appendOperationLogs(opLogs);
+            if (!sysLogs.empty()) dataManager->appendSystemLogs(sysLogs);
+            if (!accessLogs.empty()) dataManager->appendAccessLogs(accessLogs);
+        } catch (...) {
+            // 写盘失败时丢弃本批，避免阻塞后续日志
+        }
+        writtenCount.fetch_add(count, std::memory_order_release);
+        return count;
+    }
+
+    void drainPeriodic() {
+        std::lock_guard<std::mutex> lock(sourceMutex);
+        if (!periodicSource) return;
+        try {
+            std::vector<OperationLog> logs = periodicSource();
+            if (!logs.empty()) dataManager->appendOperationLogs(logs);
+        } catch (...) {
+            // 与 drainBatch 相同：写盘失败时丢弃
+        }
+    }
+
+    void writerLoop() {
+        while (true) {
+            drainPeriodic();
+            size_t written = drainBatch();
+            if (written > 0) {
+                std::lock_guard<std::mutex> lock(wakeMutex);
+                flushedCv.notify_all();
+            }
+            if (written == BATCH_SIZE) continue; // 仍有积压，继续写
+
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            if (stopping.load() && ring.sizeApprox() == 0) {
+                flushedCv.notify_all();
+                return;
+            }
+            // 空闲时按固定间隔批量写入；flush()/关闭/队列满时提前唤醒
+            wakeCv.wait_for(lock, FLUSH_INTERVAL, [this] {
+                return stopping.load() || flushRequested.load();
+            });
+            flushRequested.store(false);
+        }
+    }
+
+public:
+    explicit LogPipeline(DataManager* dm, size_t capacity = 65536)
+        : dataManager(dm), ring(capacity) {
+        writer = std::thread([this] { writerLoop(); });
+    }
+
+    ~LogPipeline() {
+        stopping.store(true);
+        wakeWriter();
+        if (writer.joinable()) writer.join();
+    }
+
+    LogPipeline(const LogPipeline&) = delete;
+    LogPipeline& operator=(const LogPipeline&) = delete;
+
+    // 设置或清除（传入空函数）定时日志来源；返回后旧来源不会再被调用
+    void setPeriodicSource(PeriodicSource source) {
+        std::lock_guard<std::mutex> lock(sourceMutex);
+        periodicSource = std::move(source);
+    }
+
+    void submit(OperationLog log) { push(Record(std::move(log))); }
+    void submit(SystemLog log) { push(Record(std::move(log))); }
+    void submit(AccessLog log) { push(Record(std::move(log))); }
+
+    // 等待调用前提交的日志全部落盘（出队按写入位置顺序进行）
+    void flush() {
+        uint64_t target = ring.enqueued();
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        flushRequested.store(true);
+        wakeCv.notify_one();
+        flushedCv.wait(lock, [&] {
+            return writtenCount.load(std::memory_order_acquire) >= target;
+        });
+    }
+};
+
+#endif // LOG_PIPELINE_H
@@ -0,0 +1,98 @@
+#ifndef LOG_POLICY_H
+#define LOG_POLICY_H
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <memory>
+#include <string>
+#include <vector>
+#include "models.h"
+
+// 操作日志策略表：按顺序匹配模块与方法，返回本次操作的记录方式
+// 策略表整体替换（原子交换 shared_ptr），热更新时不阻塞正在记录日志的请求线程
+class LogPolicyTable {
+public:
+    enum class Decision { LOG, SKIP, AGGREGATE };
+
+private:
+    struct Table {
+        std::vector<LogPolicy> policies;
+        std::unique_ptr<std::atomic<uint64_t>[]> counters; // 每条 sample 策略的命中计数
+    };
+
+    std::shared_ptr<const Table> table = std::make_shared<Table>();
+
+    static bool matches(const std::string& pattern, const std::string& value) {
+        return pattern == "*" || pattern == value;
+    }
+
+public:
+    // 取操作描述中的HTTP方法（"GET /students" -> "GET"），非HTTP操作（如"登录"）返回空串
+    static std::string methodOf(const std::string& action) {
+        size_t end = action.find(' ');
+        if (end == std::string::npos || end == 0) return "";
+        for (size_t i = 0; i < end; ++i) {
+            if (!std::isupper(static_cast<unsigned char>(action[i]))) return "";
+        }
+        return action.substr(0, end);
+    }
+
+    // 操作描述对应的路由模板，用作按分钟汇总的键：去掉 " | " 之后的参数说明，
+    // 路径中含数字或非 ASCII 字符的段（学号、课程号、生成的ID、班级名等）替换为 ":id"
+    // "GET /students/S001 | page=2" -> "GET /students/:id"；非HTTP操作原样返回
+    static std::string routeOf(const std::string& action) {
+        std::string route = action.substr(0, action.find(" | "));
+        if (methodOf(route).empty()) return route;
+        std::string result;
+        size_t start = 0;
+        while (start <= route.size()) {
+            size_t end = route.find('/', start);
+            if (end == std::string::npos) end = route.size();
+            std::string segment = route.substr(start, end - start);
+            bool parameter = start > 0 && std::any_of(segment.begin(), segment.end(), [](char c) {
+                unsigned char u = static_cast<unsigned char>(c);
+                return std::isdigit(u) || u >= 0x80;
+            });
+            result += parameter ? ":id" : segment;
+            if (end < route.size()) result += '/';
+            start = end + 1;
+        }
+        return result;
+    }
+
+    // 替换策略表（采样计数随之清零）
+    void reload(const std::vector<LogPolicy>& policies) {
+        auto next = std::make_shared<Table>();
+        next->policies = policies;
+        next->counters.reset(new std::atomic<uint64_t>[policies.size()]);
+        for (size_t i = 0; i < policies.size(); ++i) next->counters[i].store(0);
+        std::atomic_store(&table, std::shared_ptr<const Table>(std::move(next)));
+    }
+
+    std::vector<LogPolicy> policies() const {
+        return std::atomic_load(&table)->policies;
+    }
+
+    // 未命中任何策略时全部记录
+    Decision decide(const std::string& module, const std::string& action) const {
+        auto current = std::atomic_load(&table);
+        std::string method = methodOf(action);
+        for (size_t i = 0; i < current->policies.size(); ++i) {
+            const auto& policy = current->policies[i];
+            if (!matches(policy.module, module) || !matches(policy.method, method)) continue;
+
+            if (policy.mode == "off") return Decision::SKIP;
+            if (policy.mode == "aggregate") return Decision::AGGREGATE;
+            if (policy.mode == "sample" && policy.sampleRate > 1) {
+                // 每N次命中记录第1次
+                uint64_t n = current->counters[i].fetch_add(1, std::memory_order_relaxed);
+                return n % static_cast<uint64_t>(policy.sampleRate) == 0 ? Decision::LOG : Decision::SKIP;
+            }
+            return Decision::LOG;
+        }
+        return Decision::LOG;
+    }
+};
+
+#endif // LOG_POLICY_H
@@ -0,0 +1,559 @@
+#ifndef LOG_QUERY_H
+#define LOG_QUERY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "models.h"
+#include "log_store.h"
+#include "log_export.h"
+#include "log_text.h"
+
+// 日志位图：第 i 位对应序号为 i 的日志，未分配的高位视为 0
+class LogBitmap {
+private:
+    std::vector<uint64_t> words;
+
+    static int highestBit(uint64_t word) {
+    #if defined(__GNUC__) || defined(__clang__)
+        return 63 - __builtin_clzll(word);
+    #else
+        int bit = 63;
+        while (!(word >> bit)) --bit;
+        return bit;
+    #endif
+    }
+
+    static int lowestBit(uint64_t word) {
+    #if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(word);
+    #else
+        int bit = 0;
+        while (!(word >> bit & 1)) ++bit;
+        return bit;
+    #endif
+    }
+
+    static int popcount(uint64_t word) {
+    #if defined(__GNUC__) || defined(__clang__)
+        return __builtin_popcountll(word);
+    #else
+        int n = 0;
+        for (; word; word &= word - 1) ++n;
+        return n;
+    #endif
+    }
+
+public:
+    void set(uint32_t i) {
+        size_t w = i >> 6;
+        if (w >= words.size()) words.resize(w + 1, 0);
+        words[w] |= uint64_t(1) << (i & 63);
+    }
+
+    bool test(uint32_t i) const {
+        size_t w = i >> 6;
+        return w < words.size() && (words[w] >> (i & 63) & 1);
+    }
+
+    // 置位 [begin, end)，整字直接填充
+    void setRange(uint32_t begin, uint32_t end) {
+        if (begin >= end) return;
+        size_t last = (end - 1) >> 6;
+        if (last >= words.size()) words.resize(last + 1, 0);
+        size_t first = begin >> 6;
+        uint64_t head = ~uint64_t(0) << (begin & 63);
+        uint64_t tail = ~uint64_t(0) >> (63 - ((end - 1) & 63));
+        if (first == last) {
+            words[first] |= head & tail;
+            return;
+        }
+        words[first] |= head;
+        std::fill(words.begin() + first + 1, words.begin() + last, ~uint64_t(0));
+        words[last] |= tail;
+    }
+
+    void andWith(const LogBitmap& other) {
+        if (words.size() > other.words.size()) words.resize(other.words.size());
+        for (size_t i = 0; i < words.size(); ++i) words[i] &= other.words[i];
+    }
+
+    size_t count() const {
+        size_t n = 0;
+        for (uint64_t word : words) n += popcount(word);
+        return n;
+    }
+
+    // 从高位到低位（从新到旧）遍历置位：先整字跳过 skip 个，fn 返回 false 时停止
+    template<typename F>
+    void forEachDescending(size_t skip, F&& fn) const {
+        for (size_t w = words.size(); w-- > 0;) {
+            uint64_t word = words[w];
+            if (word == 0) continue;
+            size_t bits = popcount(word);
+            if (skip >= bits) {
+                skip -= bits;
+                continue;
+            }
+            while (word) {
+                int bit = highestBit(word);
+                word &= ~(uint64_t(1) << bit);
+                if (skip > 0) {
+                    --skip;
+                    continue;
+                }
+                if (!fn(static_cast<uint32_t>(w * 64 + bit))) return;
+            }
+        }
+    }
+
+    // 从低位到高位（从旧到新）遍历置位，约定同 forEachDescending
+    template<typename F>
+    void forEachAscending(size_t skip, F&& fn) const {
+        for (size_t w = 0; w < words.size(); ++w) {
+            uint64_t word = words[w];
+            if (word == 0) continue;
+            size_t bits = popcount(word);
+            if (skip >= bits) {
+                skip -= bits;
+                continue;
+            }
+            while (word) {
+                int bit = lowestBit(word);
+                word &= word - 1;
+                if (skip > 0) {
+                    --skip;
+                    continue;
+                }
+                if (!fn(static_cast<uint32_t>(w * 64 + bit))) return;
+            }
+        }
+    }
+};
+
+// 可检索的字段：级别与模块建位图，用户建有序序号表，文本按段建倒排表；没有该字段的日志类型返回空串
+template<typename T>
+struct LogQueryFields;
+
+template<>
+struct LogQueryFields<SystemLog> {
+    static std::string_view level(const SystemLog& log) { return log.level; }
+    static std::string_view module(const SystemLog& log) { return log.module; }
+    static std::string_view user(const SystemLog&) { return {}; }
+    static std::string_view text(const SystemLog& log) { return log.message; }
+};
+
+template<>
+struct LogQueryFields<OperationLog> {
+    static std::string_view level(const OperationLog&) { return {}; }
+    static std::string_view module(const OperationLog& log) { return log.module; }
+    static std::string_view user(const OperationLog& log) { return log.userId; }
+    static std::string_view text(const OperationLog&) { return {}; }
+};
+
+// 日志检索条件：各条件之间为"与"，空串表示不限
+struct LogQuery {
+    std::string level;
+    std::string module;
+    std::string userId;
+    std::string text; // 全文检索：消息须包含其中全部词（见 LogText::tokenize）
+    std::optional<LogTimeRange> range;
+    size_t skip = 0;
+    size_t limit = 10;
+    bool newestFirst = true; // false 时从旧到新分页
+};
+
+// 日志检索索引：每条日志按写入顺序分配序号，级别/模块各值对应一个位图，
+// 时间条件按各段日志的时间范围剪枝（只有跨越边界的段逐条比较时间），条件位图求交后从高位取一页；
+// 文本条件在每段的倒排表中求交，段被清理时其倒排表随之丢弃
+// 用户的序号表同时提供按用户的游标分页（用户操作日志）
+// 由日志写线程通过 LogStore 订阅同步维护；段被清理时只标记失效，失效过半时压缩序号
+template<typename T>
+class LogQueryIndex {
+public:
+    struct Result {
+        std::vector<LogPosition> positions; // 按 LogQuery::newestFirst 的顺序
+        size_t total = 0;
+    };
+
+    // 某用户的一页日志
+    struct UserPage {
+        std::vector<LogPosition> positions; // 从新到旧
+        size_t total = 0;                   // 该用户的日志总数
+        bool hasMore = false;               // 本页之后是否还有更早的日志
+    };
+
+private:
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    // 段在序号空间中的区间 [first, end)
+    struct Slot {
+        uint64_t key = 0;
+        uint32_t day = 0; // YYYYMMDD
+        uint32_t minTime = NONE; // 段内日志时间范围（秒）；晚到的日志写入当时的末段，可能早于段的日期
+        uint32_t maxTime = 0;
+        uint32_t first = 0;
+        uint32_t end = 0;
+        bool alive = true;
+        std::unordered_map<std::string, std::vector<uint32_t>> postings; // 词 -> 段内日志序号（升序）
+    };
+
+    mutable std::shared_mutex mutex;
+    std::vector<Slot> slots;                 // 按 first 升序
+    std::vector<uint32_t> offsets;           // 序号 -> 段内偏移
+    std::vector<uint32_t> times;             // 序号 -> 时间（秒，仅用于比较）
+    std::unordered_map<std::string, LogBitmap> byLevel;
+    std::unordered_map<std::string, LogBitmap> byModule;
+    std::unordered_map<std::string, std::vector<uint32_t>> byUser; // 序号升序，只含未失效的段
+    size_t deadRecords = 0;
+
+    // 按公历折算的秒数（不涉及时区，只要求同一格式下保序），格式不符返回 nullopt
+    static std::optional<uint32_t> secondsOf(const std::string& text) {
+        if (text.size() != 19) return std::nullopt;
+        int v[6];
+        const int starts[6] = {0, 5, 8, 11, 14, 17};
+        const int widths[6] = {4, 2, 2, 2, 2, 2};
+        for (int k = 0; k < 6; ++k) {
+            int n = 0;
+            for (int i = starts[k]; i < starts[k] + widths[k]; ++i) {
+                if (text[i] < '0' || text[i] > '9') return std::nullopt;
+                n = n * 10 + (text[i] - '0');
+            }
+            v[k] = n;
+        }
+        return daySeconds(v[0] * 10000 + v[1] * 100 + v[2]) + v[3] * 3600 + v[4] * 60 + v[5];
+    }
+
+    // YYYYMMDD 当天零点的秒数（days-from-civil）
+    static uint32_t daySeconds(uint32_t day) {
+        int y = static_cast<int>(day / 10000);
+        unsigned m = day / 100 % 100;
+        unsigned d = day % 100;
+        y -= m <= 2;
+        int era = (y >= 0 ? y : y - 399) / 400;
+        unsigned yoe = static_cast<unsigned>(y - era * 400);
+        unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+        unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        int64_t days = static_cast<int64_t>(era) * 146097 + static_cast<int64_t>(doe) - 719468;
+        return days < 0 ? 0 : static_cast<uint32_t>(days * 86400);
+    }
+
+    const Slot& slotOf(uint32_t ordinal) const {
+        auto it = std::upper_bound(slots.begin(), slots.end(), ordinal,
+            [](uint32_t value, const Slot& slot) { return value < slot.first; });
+        return *(it - 1);
+    }
+
+    LogPosition positionOf(uint32_t ordinal) const {
+        return LogPosition{slotOf(ordinal).key, offsets[ordinal]};
+    }
+
+    // 位置对应的序号（该段内第一条偏移不小于 pos 的日志）；段不存在或已失效时返回 nullopt
+    std::optional<uint32_t> ordinalAt(const LogPosition& pos) const {
+        for (const auto& slot : slots) {
+            if (!slot.alive || slot.key != pos.segment) continue;
+            auto begin = offsets.begin() + slot.first;
+            return static_cast<uint32_t>(std::lower_bound(begin, offsets.begin() + slot.end, pos.offset) -
+                                         offsets.begin());
+        }
+        return std::nullopt;
+    }
+
+    // 从用户序号表中移除已失效段的序号
+    void pruneUsersLocked(const LogBitmap& dead) {
+        for (auto it = byUser.begin(); it != byUser.end();) {
+            auto& ordinals = it->second;
+            ordinals.erase(std::remove_if(ordinals.begin(), ordinals.end(),
+                [&dead](uint32_t i) { return dead.test(i); }), ordinals.end());
+            if (ordinals.empty()) {
+                it = byUser.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    // 仍存在的段中满足时间条件的日志
+    LogBitmap timeCandidates(const std::optional<LogTimeRange>& range) const {
+        LogBitmap candidates;
+        uint32_t fromSec = 0, toSec = NONE;
+        if (range.has_value()) {
+            if (!range->from.empty()) fromSec = secondsOf(range->from).value_or(0);
+            if (!range->to.empty()) toSec = secondsOf(range->to).value_or(NONE);
+        }
+        for (const auto& slot : slots) {
+            if (!slot.alive || slot.maxTime < fromSec || slot.minTime > toSec) continue;
+            if (slot.minTime >= fromSec && slot.maxTime <= toSec) {
+                candidates.setRange(slot.first, slot.end);
+                continue;
+            }
+            for (uint32_t i = slot.first; i < slot.end; ++i) {
+                if (times[i] >= fromSec && times[i] <= toSec) candidates.set(i);
+            }
+        }
+        return candidates;
+    }
+
+    // 丢弃失效段，序号重新连续编排
+    void compactLocked() {
+        std::vector<uint32_t> remap(offsets.size(), NONE);
+        std::vector<Slot> keptSlots;
+        std::vector<uint32_t> keptOffsets;
+        std::vector<uint32_t> keptTimes;
+        keptOffsets.reserve(offsets.size() - deadRecords);
+        keptTimes.reserve(offsets.size() - deadRecords);
+        for (auto& slot : slots) {
+            if (!slot.alive) continue;
+            uint32_t first = static_cast<uint32_t>(keptOffsets.size());
+            for (uint32_t i = slot.first; i < slot.end; ++i) {
+                remap[i] = static_cast<uint32_t>(keptOffsets.size());
+                keptOffsets.push_back(offsets[i]);
+                keptTimes.push_back(times[i]);
+            }
+            for (auto& [token, ordinals] : slot.postings) {
+                for (auto& ordinal : ordinals) ordinal = ordinal - slot.first + first;
+            }
+            slot.first = first;
+            slot.end = static_cast<uint32_t>(keptOffsets.size());
+            keptSlots.push_back(std::move(slot));
+        }
+
+        auto remapBitmaps = [&remap](std::unordered_map<std::string, LogBitmap>& bitmaps) {
+            for (auto it = bitmaps.begin(); it != bitmaps.end();) {
+                LogBitmap kept;
+                bool any = false;
+                it->second.forEachDescending(0, [&](uint32_t i) {
+                    if (remap[i] != NONE) {
+                        kept.set(remap[i]);
+                        any = true;
+                    }
+                    return true;
+                });
+                if (any) {
+                    it->second = std::move(kept);
+                    ++it;
+                } else {
+                    it = bitmaps.erase(it);
+                }
+            }
+        };
+        remapBitmaps(byLevel);
+        remapBitmaps(byModule);
+        for (auto it = byUser.begin(); it != byUser.end();) {
+            auto& ordinals = it->second;
+            size_t n = 0;
+            for (uint32_t i : ordinals) {
+                if (remap[i] != NONE) ordinals[n++] = remap[i];
+            }
+            ordinals.resize(n);
+            if (ordinals.empty()) {
+                it = byUser.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        slots.swap(keptSlots);
+        offsets.swap(keptOffsets);
+        times.swap(keptTimes);
+        deadRecords = 0;
+    }
+
+public:
+    void clear() {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        slots.clear();
+        offsets.clear();
+        times.clear();
+        byLevel.clear();
+        byModule.clear();
+        byUser.clear();
+        deadRecords = 0;
+    }
+
+    void add(const T& record, const LogPosition& pos) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        uint32_t ordinal = static_cast<uint32_t>(offsets.size());
+        if (slots.empty() || slots.back().key != pos.segment || !slots.back().alive) {
+            Slot slot;
+            slot.key = pos.segment;
+            slot.day = static_cast<uint32_t>(pos.segment / 1000);
+            slot.first = ordinal;
+            slots.push_back(slot);
+        }
+        Slot& slot = slots.back();
+        slot.end = ordinal + 1;
+        offsets.push_back(static_cast<uint32_t>(pos.offset));
+        // 无法识别的时间（早期 ctime 格式）按所在段当天零点计
+        times.push_back(secondsOf(record.createdAt).value_or(daySeconds(slot.day)));
+        slot.minTime = std::min(slot.minTime, times.back());
+        slot.maxTime = std::max(slot.maxTime, times.back());
+
+        std::string_view level = LogQueryFields<T>::level(record);
+        if (!level.empty()) byLevel[std::string(level)].set(ordinal);
+        std::string_view module = LogQueryFields<T>::module(record);
+        if (!module.empty()) byModule[std::string(module)].set(ordinal);
+        std::string_view user = LogQueryFields<T>::user(record);
+        if (!user.empty()) byUser[std::string(user)].push_back(ordinal);
+        std::string_view text = LogQueryFields<T>::text(record);
+        if (!text.empty()) {
+            for (auto& token : LogText::tokenize(text)) slot.postings[std::move(token)].push_back(ordinal);
+        }
+    }
+
+    void removeSegments(const std::vector<uint64_t>& segmentKeys) {
+        std::unordered_set<uint64_t> removed(segmentKeys.begin(), segmentKeys.end());
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        LogBitmap dead;
+        bool any = false;
+        for (auto& slot : slots) {
+            if (slot.alive && removed.count(slot.key) > 0) {
+                slot.alive = false;
+                deadRecords += slot.end - slot.first;
+                dead.setRange(slot.first, slot.end);
+                any = true;
+            }
+        }
+        if (!any) return;
+        if (deadRecords * 2 >= offsets.size()) {
+            compactLocked();
+        } else {
+            pruneUsersLocked(dead);
+        }
+    }
+
+    // 某用户从新到旧的一页：给出游标 before 时从其之前（更早）开始，否则跳过最新的 skip 条
+    UserPage userPage(const std::string& userId, const std::optional<LogPosition>& before,
+                      size_t skip, size_t limit) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        UserPage page;
+        auto it = byUser.find(userId);
+        if (it == byUser.end()) return page;
+
+        const auto& ordinals = it->second;
+        page.total = ordinals.size();
+        size_t end;
+        if (before.has_value()) {
+            auto cursor = ordinalAt(before.value());
+            if (!cursor.has_value()) return page; // 游标所在段已被清理
+            end = std::lower_bound(ordinals.begin(), ordinals.end(), cursor.value()) - ordinals.begin();
+        } else {
+            end = skip < ordinals.size() ? ordinals.size() - skip : 0;
+        }
+        size_t begin = end > limit ? end - limit : 0;
+        for (size_t i = end; i > begin; --i) page.positions.push_back(positionOf(ordinals[i - 1]));
+        page.hasMore = begin > 0;
+        return page;
+    }
+
+    // 按条件检索一页（默认从新到旧），返回日志位置与命中总数
+    Result query(const LogQuery& q) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        Result result;
+        LogBitmap candidates = timeCandidates(q.range);
+
+        auto intersect = [&candidates](const std::string& value,
+                                       const std::unordered_map<std::string, LogBitmap>& bitmaps) {
+            if (value.empty()) return true;
+            auto it = bitmaps.find(value);
+            if (it == bitmaps.end()) return false;
+            candidates.andWith(it->second);
+            return true;
+        };
+        if (!intersect(q.level, byLevel) || !intersect(q.module, byModule)) return result;
+
+        auto take = [&](uint32_t ordinal) {
+            if (result.total >= q.skip && result.positions.size() < q.limit) {
+                result.positions.push_back(positionOf(ordinal));
+            }
+            result.total++;
+        };
+
+        if (!q.text.empty()) {
+            if (!q.userId.empty()) {
+                auto it = byUser.find(q.userId);
+                if (it == byUser.end()) return result;
+                LogBitmap userBits;
+                for (uint32_t ordinal : it->second) userBits.set(ordinal);
+                candidates.andWith(userBits);
+            }
+            auto tokens = LogText::tokenize(q.text, true);
+            if (tokens.empty()) return result;
+            // 按分页方向逐段求交：段内缺少任一词即跳过整段
+            std::vector<uint32_t> matched;
+            std::vector<uint32_t> scratch;
+            std::vector<const std::vector<uint32_t>*> lists;
+            for (size_t k = 0; k < slots.size(); ++k) {
+                const Slot* slot = &slots[q.newestFirst ? slots.size() - 1 - k : k];
+                if (!slot->alive) continue;
+                lists.clear();
+                for (const auto& token : tokens) {
+                    auto it = slot->postings.find(token);
+                    if (it == slot->postings.end()) break;
+                    lists.push_back(&it->second);
+                }
+                if (lists.size() != tokens.size()) continue;
+                std::sort(lists.begin(), lists.end(),
+                    [](const auto* a, const auto* b) { return a->size() < b->size(); });
+                matched = *lists[0];
+                for (size_t k = 1; k < lists.size() && !matched.empty(); ++k) {
+                    scratch.clear();
+                    std::set_intersection(matched.begin(), matched.end(), lists[k]->begin(), lists[k]->end(),
+                                          std::back_inserter(scratch));
+                    matched.swap(scratch);
+                }
+                if (q.newestFirst) {
+                    for (auto it = matched.rbegin(); it != matched.rend(); ++it) {
+                        if (candidates.test(*it)) take(*it);
+                    }
+                } else {
+                    for (uint32_t ordinal : matched) {
+                        if (candidates.test(ordinal)) take(ordinal);
+                    }
+                }
+            }
+            return result;
+        }
+
+        if (!q.userId.empty()) {
+            // 用户取值多而稀疏，不建位图：按分页方向探测该用户的序号
+            auto it = byUser.find(q.userId);
+            if (it == byUser.end()) return result;
+            const auto& ordinals = it->second;
+            if (q.newestFirst) {
+                for (auto rit = ordinals.rbegin(); rit != ordinals.rend(); ++rit) {
+                    if (candidates.test(*rit)) take(*rit);
+                }
+            } else {
+                for (uint32_t ordinal : ordinals) {
+                    if (candidates.test(ordinal)) take(ordinal);
+                }
+            }
+            return result;
+        }
+
+        result.total = candidates.count();
+        if (q.limit == 0) return result;
+        auto collect = [&](uint32_t ordinal) {
+            result.positions.push_back(positionOf(ordinal));
+            return result.positions.size() < q.limit;
+        };
+        if (q.newestFirst) {
+            candidates.forEachDescending(q.skip, collect);
+        } else {
+            candidates.forEachAscending(q.skip, collect);
+        }
+        return result;
+    }
+};
+
+#endif // LOG_QUERY_H
@@ -0,0 +1,628 @@
+#ifndef LOG_STORE_H
+#define LOG_STORE_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+#include <ctime>
+#include <cstdint>
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <nlohmann/json.hpp>
+#include "log_codec.h"
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+// 日志清理结果
+struct LogCleanResult {
+    size_t segments = 0;   // 删除的段文件数
+    size_t records = 0;    // 删除的日志条数
+    uintmax_t bytes = 0;   // 回收的字节数
+
+    LogCleanResult& operator+=(const LogCleanResult& other) {
+        segments += other.segments;
+        records += other.records;
+        bytes += other.bytes;
+        return *this;
+    }
+};
+
+// 日志在段文件中的位置：segment 为段键（YYYYMMDD*1000+序号，跨重启不变，且与段的先后顺序一致），
+// offset 为该行在段文件中的起始字节偏移
+struct LogPosition {
+    uint64_t segment = 0;
+    uint64_t offset = 0;
+
+    bool operator<(const LogPosition& other) const {
+        return segment != other.segment ? segment < other.segment : offset < other.offset;
+    }
+    bool operator==(const LogPosition& other) const {
+        return segment == other.segment && offset == other.offset;
+    }
+
+    // 文本形式（用作分页游标）："<段键>-<偏移>"
+    std::string toString() const {
+        return std::to_string(segment) + "-" + std::to_string(offset);
+    }
+
+    static std::optional<LogPosition> parse(const std::string& text) {
+        size_t dash = text.find('-');
+        if (dash == std::string::npos || dash == 0 || dash + 1 >= text.size()) return std::nullopt;
+        try {
+            size_t used = 0;
+            LogPosition pos;
+            pos.segment = std::stoull(text.substr(0, dash), &used);
+            if (used != dash) return std::nullopt;
+            pos.offset = std::stoull(text.substr(dash + 1), &used);
+            if (used != text.size() - dash - 1) return std::nullopt;
+            return pos;
+        } catch (...) {
+            return std::nullopt;
+        }
+    }
+};
+
+// 分段日志存储：只追加的段文件，按日期滚动，单段超过大小上限时再按序号滚动
+// 目录结构：<dir>/<YYYY-MM-DD>-<序号>.seg，manifest.json 按写入顺序记录全部段，dictionary.bin 为字符串字典
+// 段内每条记录为 varint 长度 + LogCodec<T> 编码的负载，查询时才解码为原结构
+// 早期的 .ndjson 段（每行一个 JSON）仍可读取，新日志只写入二进制段
+// 日志类型需提供 LogCodec<T>、from_json 以及 createdAt 字段（YYYY-MM-DD HH:MM:SS）
+template<typename T>
+class LogStore {
+public:
+    struct Segment {
+        std::string file;
+        std::string day;     // 段的日期（YYYY-MM-DD），段内日志的日期都不晚于它
+        std::string firstDay; // 段内最早日志的日期；晚到的较早日志写入当时的末段，可能早于 day
+        int seq = 0;         // 同一天内的序号
+        size_t records = 0;
+        uintmax_t bytes = 0;
+        uint64_t key = 0;    // 段键，见 LogPosition
+        bool binary = true;  // false 为早期的 NDJSON 段
+    };
+
+    // 索引订阅者：追加时随写入线程同步更新，回调在存储锁内执行，不得回调存储本身
+    struct Observer {
+        std::function<void()> reset;                                   // 内容整体替换前清空
+        std::function<void(const T&, const LogPosition&)> added;       // 每写入一条
+        std::function<void(const std::vector<uint64_t>&)> removed;     // 删除若干段后（段键）
+    };
+
+private:
+    static constexpr const char* MANIFEST = "manifest.json";
+    static constexpr const char* DICTIONARY = "dictionary.bin";
+    static constexpr const char* SUFFIX = ".seg";
+    static constexpr const char* LEGACY_SUFFIX = ".ndjson";
+    static constexpr uint64_t MAX_FRAME_BYTES = 1 << 20; // 超过视为损坏
+
+    std::string dir;
+    uintmax_t maxSegmentBytes;
+    mutable std::mutex mutex;
+    LogDictionary dictionary;
+    std::vector<Segment> segments; // 按写入顺序排列，最后一段为当前写入段
+    std::vector<Observer> observers;
+
+    std::string pathOf(const Segment& segment) const { return dir + "/" + segment.file; }
+    std::string manifestPath() const { return dir + "/" + MANIFEST; }
+
+    static std::string fileName(const std::string& day, int seq) {
+        std::ostringstream ss;
+        ss << day << "-" << std::setw(3) << std::setfill('0') << seq << SUFFIX;
+        return ss.str();
+    }
+
+    static uint64_t segmentKey(const std::string& day, int seq) {
+        std::string digits;
+        for (char c : day) {
+            if (c != '-') digits += c;
+        }
+        return std::stoull(digits) * 1000 + static_cast<uint64_t>(seq);
+    }
+
+    static std::string formatDay(const std::tm& tm) {
+        char buf[16];
+        std::strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
+        return std::string(buf);
+    }
+
+    static bool isDay(const std::string& text) {
+        if (text.size() < 10) return false;
+        for (size_t i = 0; i < 10; ++i) {
+            if (i == 4 || i == 7) {
+                if (text[i] != '-') return false;
+            } else if (!std::isdigit(static_cast<unsigned char>(text[i]))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool endsWith(const std::string& name, const std::string& suffix) {
+        return name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    // 从段文件名解析日期、序号与格式，格式不符时返回 false
+    static bool parseFileName(const std::string& name, Segment& segment) {
+        std::string suffix;
+        if (endsWith(name, SUFFIX)) {
+            suffix = SUFFIX;
+        } else if (endsWith(name, LEGACY_SUFFIX)) {
+            suffix = LEGACY_SUFFIX;
+        } else {
+            return false;
+        }
+        if (name.size() <= 11 + suffix.size() || !isDay(name) || name[10] != '-') return false;
+        try {
+            segment.seq = std::stoi(name.substr(11, name.size() - 11 - suffix.size()));
+        } catch (...) {
+            return false;
+        }
+        segment.file = name;
+        segment.day = name.substr(0, 10);
+        segment.key = segmentKey(segment.day, segment.seq);
+        segment.binary = suffix == SUFFIX;
+        return true;
+    }
+
+    // 扫描段内容，统计条数与最早日志的日期
+    void countRecords(Segment& segment) const {
+        segment.records = 0;
+        segment.firstDay = segment.day;
+        auto counter = [&segment](const T& record, const LogPosition&) {
+            segment.records++;
+            segment.firstDay = std::min(segment.firstDay, dayOf(record.createdAt));
+        };
+        scanSegment(segment, counter);
+    }
+
+    // 截掉二进制写入段末尾不完整的记录（异常退出时可能残留），保证后续追加对齐
+    void repairTailLocked() {
+        if (segments.empty() || !segments.back().binary) return;
+        Segment& tail = segments.back();
+        std::ifstream file(pathOf(tail), std::ios::binary);
+        if (!file.is_open()) return;
+        uint64_t valid = 0;
+        std::string payload;
+        while (readFrame(file, payload)) {
+            valid = static_cast<uint64_t>(file.tellg());
+        }
+        file.close();
+        if (valid < tail.bytes) {
+            std::error_code ec;
+            fs::resize_file(pathOf(tail), valid, ec);
+            if (!ec) tail.bytes = valid;
+        }
+    }
+
+    // 读取清单；清单缺失或损坏时扫描目录重建，并以磁盘上的实际文件为准
+    void loadLocked() {
+        segments.clear();
+        std::ifstream file(manifestPath());
+        if (file.is_open()) {
+            try {
+                json j;
+                file >> j;
+                for (const auto& item : j.at("segments")) {
+                    Segment segment;
+                    if (!parseFileName(item.at("file").get<std::string>(), segment)) continue;
+                    item.at("records").get_to(segment.records);
+                    // 早期清单没有 firstDay，那时每段只含当天的日志
+                    segment.firstDay = item.value("firstDay", segment.day);
+                    if (!fs::exists(pathOf(segment))) continue;
+                    segment.bytes = fs::file_size(pathOf(segment));
+                    segments.push_back(segment);
+                }
+                return;
+            } catch (...) {
+                segments.clear();
+            }
+        }
+
+        for (const auto& entry : fs::directory_iterator(dir)) {
+            if (!entry.is_regular_file()) continue;
+            Segment segment;
+            if (!parseFileName(entry.path().filename().string(), segment)) continue;
+            segment.bytes = entry.file_size();
+            countRecords(segment);
+            segments.push_back(segment);
+        }
+        std::sort(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) {
+            return a.day != b.day ? a.day < b.day : a.seq < b.seq;
+        });
+        writeManifestLocked();
+    }
+
+    void writeManifestLocked() const {
+        json list = json::array();
+        for (const auto& segment : segments) {
+            list.push_back({
+                {"file", segment.file},
+                {"day", segment.day},
+                {"firstDay", segment.firstDay},
+                {"seq", segment.seq},
+                {"records", segment.records},
+                {"bytes", segment.bytes}
+            });
+        }
+        json j = {{"version", 1}, {"segments", list}};
+
+        std::string tmpPath = manifestPath() + ".tmp";
+        {
+            std::ofstream file(tmpPath);
+            if (!file.is_open()) return;
+            file << j.dump(2);
+        }
+        std::error_code ec;
+        fs::rename(tmpPath, manifestPath(), ec);
+    }
+
+    // 取得某天的写入段：当前段同日且未超过大小上限时继续追加，否则新建一段
+    Segment& segmentForLocked(const std::string& day) {
+        const Segment* tail = segments.empty() ? nullptr : &segments.back();
+        if (tail != nullptr && tail->binary && tail->day == day && tail->bytes < maxSegmentBytes) {
+            return segments.back();
+        }
+        int seq = 0;
+        for (const auto& segment : segments) {
+            if (segment.day == day) seq = std::max(seq, segment.seq + 1);
+        }
+        Segment segment;
+        segment.day = day;
+        segment.firstDay = day;
+        segment.seq = seq;
+        segment.file = fileName(day, seq);
+        segment.key = segmentKey(day, seq);
+        segments.push_back(segment);
+        return segments.back();
+    }
+
+    void notifyRemovedLocked(const std::vector<uint64_t>& segmentKeys) {
+        for (const auto& observer : observers) {
+            if (observer.removed) observer.removed(segmentKeys);
+        }
+    }
+
+    void appendLocked(const std::vector<T>& records) {
+        if (records.empty()) return;
+        std::ofstream out;
+        Segment* current = nullptr;
+        std::string payload;
+        std::string frame;
+        // 观察者在文件关闭（数据写入文件）后再通知，保证回调中按位置读取能读到该记录
+        std::vector<std::pair<const T*, LogPosition>> added;
+        added.reserve(records.size());
+        for (const auto& record : records) {
+            // 日期早于末段的晚到日志（如跨午夜的一批）写入末段，而不是在较新的段之后再开较早日期的段，
+            // 保证段在内存中的顺序与段键、文件名顺序一致，重启后恢复的顺序与写入时相同
+            std::string recordDay = dayOf(record.createdAt);
+            std::string day = !segments.empty() && recordDay < segments.back().day ? segments.back().day : recordDay;
+            if (current == nullptr || current->day != day || current->bytes >= maxSegmentBytes) {
+                if (out.is_open()) out.close();
+                current = &segmentForLocked(day);
+                out.open(pathOf(*current), std::ios::app | std::ios::binary);
+                if (!out.is_open()) throw std::runtime_error("Cannot open log segment " + current->file);
+            }
+            payload.clear();
+            LogCodec<T>::encode(record, dictionary, payload);
+            frame.clear();
+            LogBinary::putVarint(frame, payload.size());
+            frame.append(payload);
+            out.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+            added.emplace_back(&record, LogPosition{current->key, current->bytes});
+            current->records++;
+            current->firstDay = std::min(current->firstDay, recordDay);
+            current->bytes += frame.size();
+        }
+        out.close();
+        for (const auto& observer : observers) {
+            if (!observer.added) continue;
+            for (const auto& [record, pos] : added) observer.added(*record, pos);
+        }
+        writeManifestLocked();
+    }
+
+    static bool decodeLine(const std::string& line, T& record) {
+        if (line.empty()) return false;
+        try {
+            record = json::parse(line).get<T>();
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+
+    // 读取一条二进制记录的负载，文件结束或记录不完整时返回 false
+    static bool readFrame(std::istream& in, std::string& payload) {
+        uint64_t len = 0;
+        int shift = 0;
+        while (true) {
+            int c = in.get();
+            if (c == EOF || shift >= 64) return false;
+            len |= static_cast<uint64_t>(c & 0x7f) << shift;
+            if ((c & 0x80) == 0) break;
+            shift += 7;
+        }
+        if (len == 0 || len > MAX_FRAME_BYTES) return false;
+        payload.resize(static_cast<size_t>(len));
+        in.read(&payload[0], static_cast<std::streamsize>(len));
+        return static_cast<uint64_t>(in.gcount()) == len;
+    }
+
+    bool decodeFrame(const std::string& payload, T& record) const {
+        return LogCodec<T>::decode(payload.data(), payload.data() + payload.size(), dictionary, record);
+    }
+
+    // 顺序解析一个段文件并附带每条的位置，跳过无法解析的记录（如正在写入的末尾半条）
+    template<typename F>
+    void scanSegment(const Segment& segment, F& fn) const {
+        std::ifstream file(pathOf(segment), std::ios::binary);
+        if (!file.is_open()) return;
+        uint64_t offset = 0;
+        if (!segment.binary) {
+            std::string line;
+            while (std::getline(file, line)) {
+                uint64_t next = offset + line.size() + 1;
+                T record;
+                if (decodeLine(line, record)) fn(record, LogPosition{segment.key, offset});
+                offset = next;
+            }
+            return;
+        }
+        std::string payload;
+        while (readFrame(file, payload)) {
+            uint64_t next = static_cast<uint64_t>(file.tellg());
+            T record;
+            if (decodeFrame(payload, record)) fn(record, LogPosition{segment.key, offset});
+            offset = next;
+        }
+    }
+
+    template<typename F>
+    void readSegment(const Segment& segment, F& fn) const {
+        auto withoutPosition = [&fn](const T& record, const LogPosition&) { fn(record); };
+        scanSegment(segment, withoutPosition);
+    }
+
+    // 通知订阅者内容已整体替换，并回放全部日志
+    void replayLocked() {
+        for (const auto& observer : observers) {
+            if (observer.reset) observer.reset();
+        }
+        if (observers.empty()) return;
+        auto notify = [this](const T& record, const LogPosition& pos) {
+            for (const auto& observer : observers) {
+                if (observer.added) observer.added(record, pos);
+            }
+        };
+        for (const auto& segment : segments) scanSegment(segment, notify);
+    }
+
+    void removeAllLocked() {
+        for (const auto& segment : segments) {
+            std::error_code ec;
+            fs::remove(pathOf(segment), ec);
+        }
+        segments.clear();
+    }
+
+public:
+    explicit LogStore(const std::string& directory, uintmax_t maxBytes = 8 * 1024 * 1024)
+        : dir(directory), maxSegmentBytes(maxBytes), dictionary(directory + "/" + DICTIONARY) {
+        fs::create_directories(dir);
+        dictionary.load();
+        loadLocked();
+        repairTailLocked();
+    }
+
+    LogStore(const LogStore&) = delete;
+    LogStore& operator=(const LogStore&) = delete;
+
+    const std::string& directory() const { return dir; }
+
+    // 取日志时间中的日期部分（本地时间）；无法识别时归入当天
+    static std::string dayOf(const std::string& createdAt) {
+        if (isDay(createdAt)) return createdAt.substr(0, 10);
+
+        std::tm tm = {};
+        std::istringstream ss(createdAt);
+        ss >> std::get_time(&tm, "%a %b %d %H:%M:%S %Y"); // 旧版 ctime 格式
+        if (ss.fail()) {
+            std::time_t now = std::time(nullptr);
+        #ifdef _WIN32
+            localtime_s(&tm, &now);
+        #else
+            localtime_r(&now, &tm);
+        #endif
+        }
+        return formatDay(tm);
+    }
+
+    // 追加一批日志（单次打开段文件顺序写入，结束后更新清单）
+    void append(const std::vector<T>& records) {
+        std::lock_guard<std::mutex> lock(mutex);
+        appendLocked(records);
+    }
+
+    // 注册索引订阅者，并立即回放已有日志建立初始索引
+    void subscribe(Observer observer) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (observer.reset) observer.reset();
+        if (observer.added) {
+            auto notify = [&observer](const T& record, const LogPosition& pos) { observer.added(record, pos); };
+            for (const auto& segment : segments) scanSegment(segment, notify);
+        }
+        observers.push_back(std::move(observer));
+    }
+
+    // 按位置读取日志（相邻位置在同一段时复用文件句柄），已被清理或无法解析的位置返回 nullopt
+    std::vector<std::optional<T>> readAt(const std::vector<LogPosition>& positions) const {
+        std::vector<std::optional<T>> result(positions.size());
+        std::unordered_map<uint64_t, Segment> byKey;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto& segment : segments) byKey[segment.key] = segment;
+        }
+
+        std::ifstream file;
+        const Segment* open = nullptr;
+        std::string buffer;
+        for (size_t i = 0; i < positions.size(); ++i) {
+            const auto& pos = positions[i];
+            if (open == nullptr || open->key != pos.segment) {
+                file.close();
+                open = nullptr;
+                auto it = byKey.find(pos.segment);
+                if (it == byKey.end()) continue;
+                file.open(pathOf(it->second), std::ios::binary);
+                if (!file.is_open()) continue;
+                open = &it->second;
+            }
+            file.clear();
+            file.seekg(static_cast<std::streamoff>(pos.offset));
+            T record;
+            bool ok = open->binary ? readFrame(file, buffer) && decodeFrame(buffer, record)
+                                   : std::getline(file, buffer) && decodeLine(buffer, record);
+            if (ok) result[i] = std::move(record);
+        }
+        return result;
+    }
+
+    // 按写入顺序逐条遍历全部日志，内存占用与日志总量无关
+    // 读取时不持锁：正在写入的末尾半行与已被清理的段会被跳过
+    template<typename F>
+    void forEach(F&& fn) const {
+        for (const auto& segment : listSegments()) {
+            readSegment(segment, fn);
+        }
+    }
+
+    // 只遍历可能含有 [fromDay, toDay] 内日志的段（空串表示不限），按段内日志的日期范围跳过无关文件
+    // 段内可能混有范围外的晚到日志，调用方仍需逐条比较时间
+    template<typename F>
+    void forEachInDays(const std::string& fromDay, const std::string& toDay, F&& fn) const {
+        for (const auto& segment : listSegments()) {
+            if (!fromDay.empty() && segment.day < fromDay) continue;
+            if (!toDay.empty() && segment.firstDay > toDay) continue;
+            readSegment(segment, fn);
+        }
+    }
+
+    std::vector<T> readAll() const {
+        std::vector<T> records;
+        forEach([&](const T& record) { records.push_back(record); });
+        return records;
+    }
+
+    std::vector<Segment> listSegments() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return segments;
+    }
+
+    bool empty() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return segments.empty();
+    }
+
+    // 删除日期早于 cutoffDay（YYYY-MM-DD）的段，最多 maxSegments 个，只删文件不解析内容
+    // 给出 deferredKeys 时只把删除的段键追加到其中而不通知观察者，由调用方分批删除完毕后调用 notifyRemoved
+    LogCleanResult removeBefore(const std::string& cutoffDay, size_t maxSegments = SIZE_MAX,
+                                std::vector<uint64_t>* deferredKeys = nullptr) {
+        std::lock_guard<std::mutex> lock(mutex);
+        LogCleanResult result;
+        std::vector<Segment> kept;
+        std::vector<uint64_t> removedKeys;
+        for (const auto& segment : segments) {
+            if (segment.day >= cutoffDay || result.segments >= maxSegments) {
+                kept.push_back(segment);
+                continue;
+            }
+            std::error_code ec;
+            fs::remove(pathOf(segment), ec);
+            if (ec) {
+                kept.push_back(segment);
+                continue;
+            }
+            removedKeys.push_back(segment.key);
+            result.segments++;
+            result.records += segment.records;
+            result.bytes += segment.bytes;
+        }
+        if (result.segments > 0) {
+            segments.swap(kept);
+            writeManifestLocked();
+            if (deferredKeys != nullptr) {
+                deferredKeys->insert(deferredKeys->end(), removedKeys.begin(), removedKeys.end());
+            } else {
+                notifyRemovedLocked(removedKeys);
+            }
+        }
+        return result;
+    }
+
+    // 一次性通知观察者一批已删除的段（与 removeBefore 的 deferredKeys 配合使用）
+    void notifyRemoved(const std::vector<uint64_t>& segmentKeys) {
+        if (segmentKeys.empty()) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        notifyRemovedLocked(segmentKeys);
+    }
+
+    // 将全部段文件与清单复制到目标目录（用于备份），返回复制的字节数
+    uintmax_t copyTo(const std::string& targetDir) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        fs::create_directories(targetDir);
+        uintmax_t total = 0;
+        for (const auto& segment : segments) {
+            fs::copy_file(pathOf(segment), targetDir + "/" + segment.file, fs::copy_options::overwrite_existing);
+            total += segment.bytes;
+        }
+        for (const std::string& name : {std::string(MANIFEST), std::string(DICTIONARY)}) {
+            std::string src = dir + "/" + name;
+            if (fs::exists(src)) {
+                fs::copy_file(src, targetDir + "/" + name, fs::copy_options::overwrite_existing);
+                total += fs::file_size(src);
+            }
+        }
+        return total;
+    }
+
+    // 用另一个目录中的段文件整体替换当前内容（用于恢复备份）
+    void replaceFrom(const std::string& sourceDir) {
+        std::lock_guard<std::mutex> lock(mutex);
+        removeAllLocked();
+        std::error_code ec;
+        fs::remove(manifestPath(), ec);
+        dictionary.clear();
+        for (const auto& entry : fs::directory_iterator(sourceDir)) {
+            if (!entry.is_regular_file()) continue;
+            fs::copy_file(entry.path(), dir + "/" + entry.path().filename().string(),
+                          fs::copy_options::overwrite_existing);
+        }
+        dictionary.load();
+        loadLocked();
+        repairTailLocked();
+        replayLocked();
+    }
+
+    // 用给定日志整体替换当前内容（用于导入旧版 JSON 数组文件）
+    void replaceWith(const std::vector<T>& records) {
+        std::lock_guard<std::mutex> lock(mutex);
+        removeAllLocked();
+        for (const auto& observer : observers) {
+            if (observer.reset) observer.reset();
+        }
+        appendLocked(records);
+        writeManifestLocked();
+    }
+};
+
+#endif // LOG_STORE_H
@@ -0,0 +1,85 @@
+#ifndef LOG_TEXT_H
+#define LOG_TEXT_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+
+// 日志消息分词：ASCII 字母数字连续段为一个词（转小写），其余字符（中文等）按 UTF-8 字符切分，
+// 建索引时每个字符及相邻两字符各为一词，查询时两字以上的连续段只用相邻两字组成的词
+namespace LogText {
+    inline bool isWordChar(unsigned char c) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+    }
+
+    // UTF-8 首字节对应的字符长度
+    inline size_t charLength(unsigned char lead) {
+        if (lead >= 0xF0) return 4;
+        if (lead >= 0xE0) return 3;
+        if (lead >= 0xC0) return 2;
+        return 1;
+    }
+
+    // 全角标点与空白不参与索引
+    inline bool isSeparator(std::string_view ch) {
+        static const char* const separators[] = {
+            "，", "。", "、", "；", "：", "？", "！", "（", "）", "【", "】", "“", "”", "‘", "’", "《", "》", "　"
+        };
+        for (const char* sep : separators) {
+            if (ch == sep) return true;
+        }
+        return false;
+    }
+
+    inline void appendRun(const std::vector<std::string_view>& run, bool forQuery, std::vector<std::string>& tokens) {
+        if (run.empty()) return;
+        if (!forQuery || run.size() == 1) {
+            for (auto ch : run) tokens.emplace_back(ch);
+        }
+        for (size_t i = 0; i + 1 < run.size(); ++i) {
+            tokens.emplace_back(std::string(run[i]).append(run[i + 1]));
+        }
+    }
+
+    // 返回去重后的词；forQuery 为 true 时按查询规则切分
+    inline std::vector<std::string> tokenize(std::string_view text, bool forQuery = false) {
+        std::vector<std::string> tokens;
+        std::vector<std::string_view> run; // 连续的非 ASCII 字符
+        size_t i = 0;
+        while (i < text.size()) {
+            unsigned char c = static_cast<unsigned char>(text[i]);
+            if (c < 0x80) {
+                appendRun(run, forQuery, tokens);
+                run.clear();
+                if (!isWordChar(c)) {
+                    ++i;
+                    continue;
+                }
+                std::string word;
+                while (i < text.size() && isWordChar(static_cast<unsigned char>(text[i]))) {
+                    char w = text[i++];
+                    word += (w >= 'A' && w <= 'Z') ? static_cast<char>(w - 'A' + 'a') : w;
+                }
+                tokens.push_back(std::move(word));
+                continue;
+            }
+            size_t len = std::min(charLength(c), text.size() - i);
+            std::string_view ch = text.substr(i, len);
+            i += len;
+            if (isSeparator(ch)) {
+                appendRun(run, forQuery, tokens);
+                run.clear();
+            } else {
+                run.push_back(ch);
+            }
+        }
+        appendRun(run, forQuery, tokens);
+
+        std::sort(tokens.begin(), tokens.end());
+        tokens.erase(std::unique(tokens.begin(), tokens.end()), tokens.end());
+        return tokens;
+    }
+}
+
+#endif // LOG_TEXT_H
@@ -5,9 +5,15 @@
 #include <vector>
 #include <algorithm>
 #include <cctype>
+#include <chrono>
+#include <map>
+#include <mutex>
 #include <crow.h>
 #include "auth.h"
 #include "data_manager.h"
+#include "log_pipeline.h"
+#include "log_policy.h"
+#include "request_timer.h"
 
 // 认证中间件
 class AuthMiddleware {
@@ -47,7 +53,7 @@ public:
     }
 
     // 检查权限中间件
-    bool checkPermission(const crow::request& req, crow::response& res, const std::vector<std::string>& requiredRoles) {
+    bool checkPermission(const crow::request& req, crow::response& res, RoleMask required) {
         auto token = getTokenFromRequest(req);
         if (!token.has_value()) {
             res.code = 401;
@@ -55,7 +61,7 @@ public:
             return false;
         }
         
-        if (!authManager->hasPermission(token.value(), requiredRoles)) {
+        if (!authManager->hasPermission(token.value(), required)) {
             res.code = 403;
             res.body = R"({"error": "Forbidden", "message": "Insufficient permissions"})";
             return false;
@@ -72,16 +78,89 @@ public:
     }
 };
 
-// 日志中间件
+// 日志中间件（日志写入异步管道，不在请求线程中读写日志文件）
+// 操作日志按系统设置中的 logPolicies 决定全部记录、采样、按分钟汇总或不记录
 class LogMiddleware {
 private:
     DataManager* dataManager;
+    LogPipeline* pipeline;
+    LogPolicyTable policies;
+
+    // 按分钟汇总的操作计数：(模块, 路由模板) -> 次数（不含分页、筛选等参数与路径中的ID）
+    std::mutex aggregateMutex;
+    std::map<std::pair<std::string, std::string>, uint64_t> aggregateCounts;
+    long long aggregateMinute = -1;
+    std::string aggregateStartedAt;
+
+    static long long currentMinute() {
+        return std::chrono::duration_cast<std::chrono::minutes>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // 取出已结束（或全部，force 为真时）的汇总窗口，每个 (模块, 路由模板) 一条操作日志
+    std::vector<OperationLog> takeAggregates(bool force) {
+        std::map<std::pair<std::string, std::string>, uint64_t> finished;
+        std::string startedAt;
+        {
+            std::lock_guard<std::mutex> lock(aggregateMutex);
+            if (aggregateCounts.empty()) return {};
+            if (!force && aggregateMinute == currentMinute()) return {};
+            finished.swap(aggregateCounts);
+            startedAt = aggregateStartedAt;
+        }
+        std::vector<OperationLog> logs;
+        logs.reserve(finished.size());
+        for (const auto& [key, count] : finished) {
+            logs.push_back(OperationLog{
+                dataManager->generateId(),
+                "",
+                "",
+                key.second + "（汇总 " + std::to_string(count) + " 次）",
+                key.first,
+                std::nullopt,
+                startedAt
+            });
+        }
+        return logs;
+    }
+
+    void rollAggregates(bool force) {
+        for (auto& log : takeAggregates(force)) pipeline->submit(std::move(log));
+    }
+
+    void aggregate(const std::string& action, const std::string& module) {
+        rollAggregates(false);
+        std::lock_guard<std::mutex> lock(aggregateMutex);
+        if (aggregateCounts.empty()) {
+            aggregateMinute = currentMinute();
+            aggregateStartedAt = dataManager->getCurrentTimestamp();
+        }
+        aggregateCounts[{module, LogPolicyTable::routeOf(action)}]++;
+    }
 
 public:
-    LogMiddleware(DataManager* dm) : dataManager(dm) {}
+    // 管道写线程定时取出已结束的汇总窗口，没有后续操作日志时也按分钟写出
+    LogMiddleware(DataManager* dm, LogPipeline* lp) : dataManager(dm), pipeline(lp) {
+        reloadPolicies();
+        pipeline->setPeriodicSource([this] { return takeAggregates(false); });
+    }
+
+    ~LogMiddleware() {
+        pipeline->setPeriodicSource(nullptr);
+        rollAggregates(true);
+    }
+
+    LogMiddleware(const LogMiddleware&) = delete;
+    LogMiddleware& operator=(const LogMiddleware&) = delete;
+
+    // 从系统设置重新加载日志策略（设置更新或恢复备份后调用，无需重启）
+    void reloadPolicies() {
+        policies.reload(dataManager->getSettings().logPolicies);
+    }
 
     // 记录系统日志（统一规范日志级别为大写短标识：INFO/WARN/ERROR）
     void logSystem(const std::string& level, const std::string& message, const std::string& module, const std::string& ip = "") {
+        StageScope stage(RequestStage::LOG);
         auto normalizeLevel = [](std::string l) {
             std::transform(l.begin(), l.end(), l.begin(), [](unsigned char c){ return std::tolower(c); });
             if (l == "warning" || l == "warn") return std::string("WARN");
@@ -89,23 +168,30 @@ public:
             return std::string("INFO");
         };
 
-        auto logs = dataManager->getSystemLogs();
-        SystemLog log{
+        pipeline->submit(SystemLog{
             dataManager->generateId(),
             normalizeLevel(level),
             message,
             module,
             ip.empty() ? std::nullopt : std::optional<std::string>(ip),
             dataManager->getCurrentTimestamp()
-        };
-        logs.push_back(log);
-        dataManager->saveSystemLogs(logs);
+        });
     }
 
-    // 记录操作日志
+    // 记录操作日志（受日志策略控制）
     void logOperation(const std::string& userId, const std::string& username, const std::string& action, const std::string& module, const std::string& ip = "") {
-        auto logs = dataManager->getOperationLogs();
-        OperationLog log{
+        StageScope stage(RequestStage::LOG);
+        switch (policies.decide(module, action)) {
+            case LogPolicyTable::Decision::SKIP:
+                return;
+            case LogPolicyTable::Decision::AGGREGATE:
+                aggregate(action, module);
+                return;
+            case LogPolicyTable::Decision::LOG:
+                break;
+        }
+        rollAggregates(false);
+        pipeline->submit(OperationLog{
             dataManager->generateId(),
             userId,
             username,
@@ -113,31 +199,19 @@ public:
             module,
             ip.empty() ? std::nullopt : std::optional<std::string>(ip),
             dataManager->getCurrentTimestamp()
-        };
-        logs.push_back(log);
-        dataManager->saveOperationLogs(logs);
+        });
     }
 
-    // 记录请求日志
-    void logRequest(const crow::request& req, const crow::response& res, const std::optional<User>& user = std::nullopt) {
-        std::string action = "REQUEST";
-        std::string module = "API";
-        std::string ip = req.get_header_value("X-Forwarded-For");
-        if (ip.empty()) ip = req.get_header_value("Remote-Addr");
-        
-        std::string level = (res.code >= 400) ? "WARN" : "INFO";
-        std::string message = "Request processed | Response: " + std::to_string(res.code);
-        
-        if (user.has_value()) {
-            logOperation(user.value().id, user.value().username, action, module, ip);
-        } else {
-            logSystem(level, message, module, ip);
-        }
+    // 写出当前汇总窗口并等待已提交的日志全部落盘
+    void flush() {
+        rollAggregates(true);
+        pipeline->flush();
     }
 };
 
 // 辅助函数：JSON响应
 inline crow::response jsonResponse(const json& data, int code = 200) {
+    StageScope stage(RequestStage::SERIALIZE);
     crow::response res(code);
     res.set_header("Content-Type", "application/json");
     res.body = data.dump();
@@ -145,6 +219,7 @@ inline crow::response jsonResponse(const json& data, int code = 200) {
 }
 
 inline crow::response jsonResponse(const std::string& message, int code = 200) {
+    StageScope stage(RequestStage::SERIALIZE);
     json j = {{"message", message}};
     crow::response res(code);
     res.set_header("Content-Type", "application/json");
@@ -163,6 +238,7 @@ inline crow::response errorResponse(const std::string& error, const std::string&
 // 分页辅助函数（支持ISO日期转换）
 template<typename T>
 json paginate(const std::vector<T>& data, int page, int limit) {
+    StageScope stage(RequestStage::SERIALIZE);
     int total = data.size();
     int start = (page - 1) * limit;
     int end = std::min(start + limit, total);
@@ -196,6 +272,7 @@ json paginate(const std::vector<T>& data, int page, int limit) {
 template<typename T>
 json paginateWithISO(const std::vector<T>& data, int page, int limit, 
                      std::function<std::string(const std::string&)> convertFunc) {
+    StageScope stage(RequestStage::SERIALIZE);
     int total = data.size();
     int start = (page - 1) * limit;
     int end = std::min(start + limit, total);
@@ -323,6 +323,54 @@ struct SystemLog {
     }
 };
 
+// 访问日志模型（每个HTTP请求一条，耗时单位为微秒）
+struct AccessLog {
+    std::string method;
+    std::string route;       // 路由模板（路径中的ID段替换为 <id>）
+    int status = 0;
+    uint64_t bytes = 0;      // 响应体字节数
+    int64_t totalUs = 0;
+    int64_t authUs = 0;
+    int64_t dataUs = 0;
+    int64_t computeUs = 0;
+    int64_t serializeUs = 0;
+    int64_t logUs = 0;
+    std::optional<std::string> ip;
+    std::string createdAt;
+
+    friend void to_json(json& j, const AccessLog& log) {
+        j = json{
+            {"method", log.method},
+            {"route", log.route},
+            {"status", log.status},
+            {"bytes", log.bytes},
+            {"totalUs", log.totalUs},
+            {"authUs", log.authUs},
+            {"dataUs", log.dataUs},
+            {"computeUs", log.computeUs},
+            {"serializeUs", log.serializeUs},
+            {"logUs", log.logUs},
+            {"createdAt", log.createdAt}
+        };
+        if (log.ip.has_value()) j["ip"] = log.ip.value();
+    }
+
+    friend void from_json(const json& j, AccessLog& log) {
+        j.at("method").get_to(log.method);
+        j.at("route").get_to(log.route);
+        j.at("status").get_to(log.status);
+        j.at("bytes").get_to(log.bytes);
+        j.at("totalUs").get_to(log.totalUs);
+        j.at("authUs").get_to(log.authUs);
+        j.at("dataUs").get_to(log.dataUs);
+        j.at("computeUs").get_to(log.computeUs);
+        j.at("serializeUs").get_to(log.serializeUs);
+        j.at("logUs").get_to(log.logUs);
+        if (j.contains("ip") && !j["ip"].is_null()) log.ip = j["ip"].get<std::string>();
+        j.at("createdAt").get_to(log.createdAt);
+    }
+};
+
 // 备份模型
 struct Backup {
     std::string id;
@@ -350,19 +398,49 @@ struct Backup {
     }
 };
 
+// 操作日志记录策略：按模块与HTTP方法匹配，按顺序取第一条命中的策略
+struct LogPolicy {
+    std::string module = "*";    // 模块名，"*" 匹配全部
+    std::string method = "*";    // GET/POST/PUT/DELETE，"*" 匹配全部
+    std::string mode = "always"; // always 全部记录 / sample 每N次记录1次 / aggregate 按分钟汇总 / off 不记录
+    int sampleRate = 1;          // sample 模式下的N
+
+    static bool isValidMode(const std::string& mode) {
+        return mode == "always" || mode == "sample" || mode == "aggregate" || mode == "off";
+    }
+
+    friend void to_json(json& j, const LogPolicy& p) {
+        j = json{
+            {"module", p.module},
+            {"method", p.method},
+            {"mode", p.mode},
+            {"sampleRate", p.sampleRate}
+        };
+    }
+
+    friend void from_json(const json& j, LogPolicy& p) {
+        p.module = j.value("module", std::string("*"));
+        p.method = j.value("method", std::string("*"));
+        p.mode = j.value("mode", std::string("always"));
+        p.sampleRate = j.value("sampleRate", 1);
+    }
+};
+
 // 系统设置模型
 struct SystemSettings {
     int backupInterval;
     int logRetentionDays;
     int maxLoginAttempts;
     int sessionTimeout;
+    std::vector<LogPolicy> logPolicies; // 为空时记录全部操作
 
     friend void to_json(json& j, const SystemSettings& s) {
         j = json{
             {"backupInterval", s.backupInterval},
             {"logRetentionDays", s.logRetentionDays},
             {"maxLoginAttempts", s.maxLoginAttempts},
-            {"sessionTimeout", s.sessionTimeout}
+            {"sessionTimeout", s.sessionTimeout},
+            {"logPolicies", s.logPolicies}
         };
     }
 
@@ -371,6 +449,10 @@ struct SystemSettings {
         j.at("logRetentionDays").get_to(s.logRetentionDays);
         j.at("maxLoginAttempts").get_to(s.maxLoginAttempts);
         j.at("sessionTimeout").get_to(s.sessionTimeout);
+        s.logPolicies.clear();
+        if (j.contains("logPolicies") && j["logPolicies"].is_array()) {
+            j["logPolicies"].get_to(s.logPolicies);
+        }
     }
 };
 
@@ -0,0 +1,92 @@
+#ifndef MPSC_RING_BUFFER_H
+#define MPSC_RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// 无锁有界环形队列：多生产者、单消费者
+// 每个槽位带序号（Vyukov 有界队列），生产者通过 CAS 抢占写入位置，push/pop 均为 O(1)
+// 容量会向上取整为 2 的幂
+template<typename T>
+class MpscRingBuffer {
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> buffer;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueuePos{0};
+    alignas(64) std::atomic<size_t> dequeuePos{0};
+
+    static size_t roundUpPow2(size_t n) {
+        size_t cap = 2;
+        while (cap < n) cap <<= 1;
+        return cap;
+    }
+
+public:
+    explicit MpscRingBuffer(size_t capacity) {
+        size_t cap = roundUpPow2(capacity);
+        buffer.reset(new Cell[cap]);
+        mask = cap - 1;
+        for (size_t i = 0; i < cap; ++i) {
+            buffer[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRingBuffer(const MpscRingBuffer&) = delete;
+    MpscRingBuffer& operator=(const MpscRingBuffer&) = delete;
+
+    size_t capacity() const { return mask + 1; }
+
+    // 尝试写入，队列满时返回 false（此时 value 保持不变，可重试）
+    bool tryPush(T& value) {
+        Cell* cell;
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &buffer[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 取出一条（仅允许单个消费者线程调用），队列空时返回 false
+    bool tryPop(T& out) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        Cell* cell = &buffer[pos & mask];
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+        if (static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1) < 0) return false;
+        out = std::move(cell->data);
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        dequeuePos.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // 已分配的写入位置总数（包含尚未完成写入的）
+    size_t enqueued() const {
+        return enqueuePos.load(std::memory_order_acquire);
+    }
+
+    // 近似的当前元素数量
+    size_t sizeApprox() const {
+        size_t head = dequeuePos.load(std::memory_order_relaxed);
+        size_t tail = enqueuePos.load(std::memory_order_relaxed);
+        return tail >= head ? tail - head : 0;
+    }
+};
+
+#endif // MPSC_RING_BUFFER_H
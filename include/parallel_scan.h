@@ -0,0 +1,71 @@
+#ifndef PARALLEL_SCAN_H
+#define PARALLEL_SCAN_H
+
+#include <algorithm>
+#include <exception>
+#include <future>
+#include <vector>
+#include "thread_pool.h"
+
+// 分区并行扫描-归约：把 [0, count) 切成连续分区，各分区在共享线程池中累计局部结果，再按分区顺序合并
+// 调用线程处理第一个分区；数据量不足两个分区时直接在调用线程中顺序执行
+// accumulate(Partial&, size_t begin, size_t end) 只写本分区的局部结果，merge(Partial&, Partial&&) 在调用线程中执行
+class ParallelScan {
+private:
+    ThreadPool& pool;
+    size_t minPartition;
+
+public:
+    explicit ParallelScan(ThreadPool& threadPool, size_t minPartitionSize = 16384)
+        : pool(threadPool), minPartition(std::max<size_t>(minPartitionSize, 1)) {}
+
+    size_t partitionsFor(size_t items) const {
+        return std::max<size_t>(1, std::min(pool.size() + 1, items / minPartition));
+    }
+
+    template<typename Partial, typename Accumulate, typename Merge>
+    Partial reduce(size_t count, const Partial& identity, Accumulate accumulate, Merge merge) const {
+        size_t parts = partitionsFor(count);
+        if (parts <= 1) {
+            Partial result = identity;
+            accumulate(result, size_t{0}, count);
+            return result;
+        }
+
+        size_t chunk = (count + parts - 1) / parts;
+        std::vector<Partial> partials(parts, identity);
+        auto run = [&](size_t part) {
+            size_t begin = std::min(count, part * chunk);
+            size_t end = std::min(count, begin + chunk);
+            accumulate(partials[part], begin, end);
+        };
+
+        std::vector<std::future<void>> futures;
+        futures.reserve(parts - 1);
+        for (size_t part = 1; part < parts; ++part) {
+            futures.push_back(pool.submit([&run, part] { run(part); }));
+        }
+
+        // 各分区引用本函数的局部变量，必须全部结束后才能返回或抛出
+        std::exception_ptr error;
+        try {
+            run(0);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        for (auto& future : futures) {
+            try {
+                future.get();
+            } catch (...) {
+                if (!error) error = std::current_exception();
+            }
+        }
+        if (error) std::rethrow_exception(error);
+
+        Partial result = std::move(partials[0]);
+        for (size_t part = 1; part < parts; ++part) merge(result, std::move(partials[part]));
+        return result;
+    }
+};
+
+#endif // PARALLEL_SCAN_H
@@ -0,0 +1,226 @@
+#ifndef PASSWORD_HASHER_H
+#define PASSWORD_HASHER_H
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+#include <openssl/crypto.h>
+#include "thread_pool.h"
+
+// 密码哈希池繁忙（队列已满）
+class PasswordHasherBusy : public std::runtime_error {
+public:
+    PasswordHasherBusy() : std::runtime_error("Password hasher queue is full") {}
+};
+
+// 密码校验结果
+struct PasswordCheck {
+    bool valid = false;       // 密码是否正确
+    bool needsRehash = false; // 是否需要以当前参数重新哈希（旧版SHA256或迭代次数变化）
+};
+
+// 密码哈希器参数
+struct PasswordHasherOptions {
+    int iterations = 100000;   // PBKDF2迭代次数（成本参数）
+    size_t workers = 0;        // 工作线程数，0 表示 CPU 核数的一半
+    size_t queueCapacity = 64; // 等待队列上限（阻塞提交的背压）
+    size_t maxPendingChecks = 0; // 同时等待结果的登录校验上限，超出则快速失败；0 表示等于工作线程数
+    size_t saltBytes = 16;
+};
+
+// 带盐、可调成本的密码哈希器（PBKDF2-HMAC-SHA256），在独立的有界线程池中执行
+// 存储格式：pbkdf2_sha256$<迭代次数>$<盐hex>$<哈希hex>
+// 旧格式：64位hex的无盐SHA256（视为版本0，登录成功后自动升级）
+class PasswordHasher {
+private:
+    PasswordHasherOptions options;
+    ThreadPool pool;
+    size_t pendingLimit;
+    std::atomic<size_t> pendingChecks{0}; // 正在等待结果的 tryVerify/tryHash 调用数
+
+    // 登录路径的准入：每个等待中的调用都占着一个请求线程，上限低于请求线程数，超出即抛出 PasswordHasherBusy
+    class PendingSlot {
+    private:
+        std::atomic<size_t>& counter;
+
+    public:
+        PendingSlot(std::atomic<size_t>& pending, size_t limit) : counter(pending) {
+            if (counter.fetch_add(1) >= limit) {
+                counter.fetch_sub(1);
+                throw PasswordHasherBusy();
+            }
+        }
+        ~PendingSlot() { counter.fetch_sub(1); }
+
+        PendingSlot(const PendingSlot&) = delete;
+        PendingSlot& operator=(const PendingSlot&) = delete;
+    };
+
+    static constexpr const char* SCHEME = "pbkdf2_sha256";
+    static constexpr int HASH_BYTES = 32;
+
+    static size_t defaultWorkers() {
+        size_t cores = std::thread::hardware_concurrency();
+        return cores > 1 ? cores / 2 : 1;
+    }
+
+    static std::string toHex(const unsigned char* data, size_t len) {
+        std::stringstream ss;
+        for (size_t i = 0; i < len; i++) {
+            ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(data[i]);
+        }
+        return ss.str();
+    }
+
+    static std::vector<unsigned char> fromHex(const std::string& hex) {
+        std::vector<unsigned char> out;
+        if (hex.size() % 2 != 0) return out;
+        out.reserve(hex.size() / 2);
+        for (size_t i = 0; i < hex.size(); i += 2) {
+            out.push_back(static_cast<unsigned char>(std::stoi(hex.substr(i, 2), nullptr, 16)));
+        }
+        return out;
+    }
+
+    static bool constantTimeEquals(const std::string& a, const std::string& b) {
+        if (a.size() != b.size()) return false;
+        return CRYPTO_memcmp(a.data(), b.data(), a.size()) == 0;
+    }
+
+    static std::string legacySha256(const std::string& str) {
+        unsigned char hash[SHA256_DIGEST_LENGTH];
+        SHA256(reinterpret_cast<const unsigned char*>(str.c_str()), str.size(), hash);
+        return toHex(hash, SHA256_DIGEST_LENGTH);
+    }
+
+    static std::string pbkdf2(const std::string& password, const std::vector<unsigned char>& salt, int iterations) {
+        unsigned char out[HASH_BYTES];
+        if (PKCS5_PBKDF2_HMAC(password.c_str(), static_cast<int>(password.size()),
+                              salt.data(), static_cast<int>(salt.size()),
+                              iterations, EVP_sha256(), HASH_BYTES, out) != 1) {
+            throw std::runtime_error("PBKDF2 failed");
+        }
+        return toHex(out, HASH_BYTES);
+    }
+
+    static bool isLegacy(const std::string& stored) {
+        return stored.size() == SHA256_DIGEST_LENGTH * 2 && stored.find('$') == std::string::npos;
+    }
+
+    // 计算哈希（在工作线程中执行）
+    std::string computeHash(const std::string& password) const {
+        std::vector<unsigned char> salt(options.saltBytes);
+        if (RAND_bytes(salt.data(), static_cast<int>(salt.size())) != 1) {
+            throw std::runtime_error("RAND_bytes failed");
+        }
+        return std::string(SCHEME) + "$" + std::to_string(options.iterations) + "$" +
+               toHex(salt.data(), salt.size()) + "$" + pbkdf2(password, salt, options.iterations);
+    }
+
+    // 校验密码（在工作线程中执行）
+    PasswordCheck computeCheck(const std::string& password, const std::string& stored) const {
+        PasswordCheck result;
+        if (isLegacy(stored)) {
+            result.valid = constantTimeEquals(legacySha256(password), stored);
+            result.needsRehash = result.valid;
+            return result;
+        }
+
+        // 解析 scheme$iterations$salt$hash
+        std::vector<std::string> parts;
+        std::stringstream ss(stored);
+        std::string part;
+        while (std::getline(ss, part, '$')) parts.push_back(part);
+        if (parts.size() != 4 || parts[0] != SCHEME) return result;
+
+        try {
+            int iterations = std::stoi(parts[1]);
+            auto salt = fromHex(parts[2]);
+            if (iterations <= 0 || salt.empty()) return result;
+            result.valid = constantTimeEquals(pbkdf2(password, salt, iterations), parts[3]);
+            result.needsRehash = result.valid && iterations != options.iterations;
+        } catch (...) {
+            result.valid = false;
+        }
+        return result;
+    }
+
+public:
+    explicit PasswordHasher(const PasswordHasherOptions& opts = PasswordHasherOptions())
+        : options(opts), pool(opts.workers > 0 ? opts.workers : defaultWorkers(), opts.queueCapacity),
+          pendingLimit(opts.maxPendingChecks > 0 ? opts.maxPendingChecks : pool.size()) {}
+
+    int iterations() const { return options.iterations; }
+
+    // 与当前成本相同的占位哈希（不对应任何密码）：用户不存在时也按它校验一次，登录耗时不暴露用户名是否存在
+    std::string dummyHash() const {
+        return std::string(SCHEME) + "$" + std::to_string(options.iterations) + "$" +
+               std::string(std::max<size_t>(options.saltBytes, 1) * 2, '0') + "$" + std::string(HASH_BYTES * 2, '0');
+    }
+
+    // 生成密码哈希，池满时阻塞等待（用于管理操作）
+    std::string hash(const std::string& password) {
+        return pool.submit([this, password] { return computeHash(password); }).get();
+    }
+
+    // 校验密码，池满时阻塞等待
+    PasswordCheck verify(const std::string& password, const std::string& stored) {
+        return pool.submit([this, password, stored] { return computeCheck(password, stored); }).get();
+    }
+
+    // 校验密码，等待中的校验已达上限或池满时抛出 PasswordHasherBusy（用于登录，避免突发流量占满请求线程）
+    PasswordCheck tryVerify(const std::string& password, const std::string& stored) {
+        PendingSlot slot(pendingChecks, pendingLimit);
+        auto future = pool.trySubmit([this, password, stored] { return computeCheck(password, stored); });
+        if (!future.has_value()) throw PasswordHasherBusy();
+        return future->get();
+    }
+
+    // 批量生成密码哈希：逐条提交，同时在池中的条目不超过工作线程数减一（至少一条）
+    // 两个及以上工作线程时始终留出一个给登录校验；只有一个工作线程时无法预留，
+    // 登录校验最多排在一条导入之后（池按提交顺序执行），而不是整批导入之后
+    // 单条失败时对应位置返回空串，错误信息写入 errors（若提供）
+    std::vector<std::string> hashBatch(const std::vector<std::string>& passwords,
+                                       std::vector<std::string>* errors = nullptr) {
+        std::vector<std::string> hashes(passwords.size());
+        if (errors) errors->assign(passwords.size(), "");
+        if (passwords.empty()) return hashes;
+
+        size_t window = std::max<size_t>(1, pool.size() - 1);
+        std::deque<std::future<void>> inFlight;
+        for (size_t i = 0; i < passwords.size(); ++i) {
+            if (inFlight.size() >= window) {
+                inFlight.front().get();
+                inFlight.pop_front();
+            }
+            inFlight.push_back(pool.submit([this, &passwords, &hashes, errors, i] {
+                try {
+                    hashes[i] = computeHash(passwords[i]);
+                } catch (const std::exception& e) {
+                    if (errors) (*errors)[i] = e.what();
+                }
+            }));
+        }
+        for (auto& future : inFlight) future.get();
+        return hashes;
+    }
+
+    // 生成密码哈希，等待中的调用已达上限或池满时抛出 PasswordHasherBusy
+    std::string tryHash(const std::string& password) {
+        PendingSlot slot(pendingChecks, pendingLimit);
+        auto future = pool.trySubmit([this, password] { return computeHash(password); });
+        if (!future.has_value()) throw PasswordHasherBusy();
+        return future->get();
+    }
+};
+
+#endif // PASSWORD_HASHER_H
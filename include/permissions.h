@@ -0,0 +1,31 @@
+#ifndef PERMISSIONS_H
+#define PERMISSIONS_H
+
+#include <cstdint>
+#include <string>
+
+// 角色位掩码：登录时由角色字符串解析一次，之后鉴权只做一次按位与
+using RoleMask = std::uint8_t;
+
+namespace Role {
+    constexpr RoleMask NONE    = 0;
+    constexpr RoleMask ADMIN   = 1u << 0;
+    constexpr RoleMask TEACHER = 1u << 1;
+    constexpr RoleMask STUDENT = 1u << 2;
+
+    inline RoleMask fromString(const std::string& role) {
+        if (role == "admin") return ADMIN;
+        if (role == "teacher") return TEACHER;
+        if (role == "student") return STUDENT;
+        return NONE;
+    }
+}
+
+// 路由所需权限（管理员拥有所有权限，因此每个掩码都包含 ADMIN 位）
+namespace Perm {
+    constexpr RoleMask ADMIN_ONLY    = Role::ADMIN;
+    constexpr RoleMask STAFF         = Role::ADMIN | Role::TEACHER;
+    constexpr RoleMask AUTHENTICATED = Role::ADMIN | Role::TEACHER | Role::STUDENT;
+}
+
+#endif // PERMISSIONS_H
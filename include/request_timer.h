@@ -0,0 +1,92 @@
+#ifndef REQUEST_TIMER_H
+#define REQUEST_TIMER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+// 请求处理阶段；未处于其他阶段的时间计入 COMPUTE
+enum class RequestStage : uint8_t {
+    COMPUTE = 0,
+    AUTH,       // 鉴权（Token校验、当前用户、登录）
+    DATA,       // 数据读写（DataManager）
+    SERIALIZE,  // JSON构造与序列化
+    LOG,        // 操作/系统日志提交
+    COUNT
+};
+
+// 单个请求的分阶段计时器：Crow 在同一线程内同步执行处理函数，
+// 因此以线程局部变量记录当前请求，服务代码通过 StageScope 标记阶段，无需传参
+// 阶段可嵌套，时间按"独占"计入最内层阶段，各阶段之和等于总耗时
+class RequestTimer {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static inline thread_local RequestTimer* active = nullptr;
+
+    Clock::time_point start;
+    Clock::time_point mark;
+    RequestStage stage = RequestStage::COMPUTE;
+    std::array<int64_t, static_cast<size_t>(RequestStage::COUNT)> nanos{};
+    int64_t totalNanos = 0;
+
+    void charge(Clock::time_point now) {
+        nanos[static_cast<size_t>(stage)] += std::chrono::duration_cast<std::chrono::nanoseconds>(now - mark).count();
+        mark = now;
+    }
+
+public:
+    static RequestTimer* current() { return active; }
+
+    void begin() {
+        start = mark = Clock::now();
+        stage = RequestStage::COMPUTE;
+        nanos.fill(0);
+        totalNanos = 0;
+        active = this;
+    }
+
+    void end() {
+        auto now = Clock::now();
+        charge(now);
+        totalNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count();
+        if (active == this) active = nullptr;
+    }
+
+    // 进入新阶段，返回之前的阶段供 leave 恢复
+    RequestStage enter(RequestStage next) {
+        charge(Clock::now());
+        RequestStage previous = stage;
+        stage = next;
+        return previous;
+    }
+
+    void leave(RequestStage previous) {
+        charge(Clock::now());
+        stage = previous;
+    }
+
+    int64_t micros(RequestStage s) const { return nanos[static_cast<size_t>(s)] / 1000; }
+    int64_t totalMicros() const { return totalNanos / 1000; }
+};
+
+// 阶段作用域标记：当前线程没有正在计时的请求时不做任何事
+class StageScope {
+private:
+    RequestTimer* timer;
+    RequestStage previous = RequestStage::COMPUTE;
+
+public:
+    explicit StageScope(RequestStage stage) : timer(RequestTimer::current()) {
+        if (timer) previous = timer->enter(stage);
+    }
+
+    ~StageScope() {
+        if (timer) timer->leave(previous);
+    }
+
+    StageScope(const StageScope&) = delete;
+    StageScope& operator=(const StageScope&) = delete;
+};
+
+#endif // REQUEST_TIMER_H
@@ -0,0 +1,157 @@
+#ifndef RETENTION_TASK_H
+#define RETENTION_TASK_H
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <nlohmann/json.hpp>
+#include "data_manager.h"
+#include "middleware.h"
+
+using json = nlohmann::json;
+
+// 日志保留后台任务：按系统设置中的 logRetentionDays 定期删除过期日志段
+// 启动时执行一次，之后每隔 interval 执行；清理在后台线程逐段进行，不占用请求线程
+class RetentionTask {
+public:
+    struct Report {
+        std::string ranAt;
+        int retentionDays = 0;
+        LogCleanResult reclaimed;
+    };
+
+private:
+    DataManager* dataManager;
+    LogMiddleware* logger;
+    std::chrono::milliseconds interval;
+    std::thread worker;
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeCv;
+    bool stopping = false;
+    bool runRequested = false;
+
+    mutable std::mutex reportMutex;
+    std::optional<Report> lastReport;
+    LogCleanResult totals;
+    size_t runs = 0;
+    bool running = false;
+    std::string nextRunAt;
+
+    static json toJson(const LogCleanResult& result) {
+        return json{
+            {"removedSegments", result.segments},
+            {"removedRecords", result.records},
+            {"reclaimedBytes", result.bytes}
+        };
+    }
+
+    std::string timestampAfter(std::chrono::milliseconds delay) const {
+        std::time_t tt = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now() + delay);
+        std::tm tm{};
+    #ifdef _WIN32
+        localtime_s(&tm, &tt);
+    #else
+        localtime_r(&tt, &tm);
+    #endif
+        char buf[32];
+        std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+        return std::string(buf);
+    }
+
+    void runOnce() {
+        int days = dataManager->getSettings().logRetentionDays;
+        {
+            std::lock_guard<std::mutex> lock(reportMutex);
+            running = true;
+        }
+
+        Report report;
+        report.ranAt = dataManager->getCurrentTimestamp();
+        report.retentionDays = days;
+        if (days > 0) { // 0 或负数表示永久保留
+            try {
+                report.reclaimed = dataManager->cleanLogs(days);
+            } catch (const std::exception& e) {
+                logger->logSystem("error", std::string("日志保留任务失败: ") + e.what(), "系统管理");
+            }
+        }
+
+        if (report.reclaimed.segments > 0) {
+            logger->logSystem("info",
+                "日志保留任务删除 " + std::to_string(report.reclaimed.segments) + " 个日志段，共 " +
+                std::to_string(report.reclaimed.records) + " 条、" +
+                std::to_string(report.reclaimed.bytes) + " 字节（保留 " + std::to_string(days) + " 天）",
+                "系统管理");
+        }
+
+        std::lock_guard<std::mutex> lock(reportMutex);
+        running = false;
+        runs++;
+        totals += report.reclaimed;
+        lastReport = report;
+        nextRunAt = timestampAfter(interval);
+    }
+
+    void loop() {
+        while (true) {
+            runOnce();
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wakeCv.wait_for(lock, interval, [this] { return stopping || runRequested; });
+            if (stopping) return;
+            runRequested = false;
+        }
+    }
+
+public:
+    RetentionTask(DataManager* dm, LogMiddleware* log,
+                  std::chrono::milliseconds runInterval = std::chrono::hours(1))
+        : dataManager(dm), logger(log), interval(runInterval) {
+        worker = std::thread([this] { loop(); });
+    }
+
+    ~RetentionTask() {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopping = true;
+        }
+        wakeCv.notify_one();
+        if (worker.joinable()) worker.join();
+    }
+
+    RetentionTask(const RetentionTask&) = delete;
+    RetentionTask& operator=(const RetentionTask&) = delete;
+
+    // 立即触发一次清理（不等待完成）
+    void runNow() {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            runRequested = true;
+        }
+        wakeCv.notify_one();
+    }
+
+    // 任务状态：最近一次执行的回收情况与启动以来的累计
+    json status() const {
+        std::lock_guard<std::mutex> lock(reportMutex);
+        json last = nullptr;
+        if (lastReport.has_value()) {
+            last = toJson(lastReport->reclaimed);
+            last["ranAt"] = lastReport->ranAt;
+            last["retentionDays"] = lastReport->retentionDays;
+        }
+        return json{
+            {"intervalSeconds", std::chrono::duration_cast<std::chrono::seconds>(interval).count()},
+            {"running", running},
+            {"runs", runs},
+            {"nextRunAt", nextRunAt.empty() ? json(nullptr) : json(nextRunAt)},
+            {"lastRun", last},
+            {"totals", toJson(totals)}
+        };
+    }
+};
+
+#endif // RETENTION_TASK_H
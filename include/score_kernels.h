@@ -0,0 +1,178 @@
+#ifndef SCORE_KERNELS_H
+#define SCORE_KERNELS_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+// x86 上的 GCC/Clang 按函数启用 AVX2，运行时检测 CPU 后选用，不依赖 -mavx2 编译选项
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SCORE_KERNELS_AVX2 1
+#define SCORE_KERNELS_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+// 分数列内核：在连续的 uint8_t 分数列上按选择掩码（非 0 字节为选中）求和、计数、最值与直方图
+// CPU 支持 AVX2 时每次处理 32 个成绩，否则使用标量实现，结果一致
+namespace ScoreKernels {
+    constexpr int BINS = 256;
+    using Histogram = std::array<uint32_t, BINS>;
+
+    namespace detail {
+        inline uint64_t sumScalar(const uint8_t* scores, const uint8_t* mask, size_t begin, size_t n) {
+            uint64_t total = 0;
+            for (size_t i = begin; i < n; ++i) total += mask[i] ? scores[i] : 0;
+            return total;
+        }
+
+        inline size_t countAtLeastScalar(const uint8_t* scores, const uint8_t* mask, size_t begin, size_t n,
+                                         uint8_t threshold) {
+            size_t total = 0;
+            for (size_t i = begin; i < n; ++i) total += (mask[i] != 0) & (scores[i] >= threshold);
+            return total;
+        }
+
+        // 在 (low, high, found) 上继续累计 [begin, n) 的选中成绩
+        inline void minMaxScalar(const uint8_t* scores, const uint8_t* mask, size_t begin, size_t n,
+                                 uint8_t& low, uint8_t& high, bool& found) {
+            for (size_t i = begin; i < n; ++i) {
+                if (!mask[i]) continue;
+                low = std::min(low, scores[i]);
+                high = std::max(high, scores[i]);
+                found = true;
+            }
+        }
+
+#ifdef SCORE_KERNELS_AVX2
+        inline bool avx2Supported() {
+#ifdef __AVX2__
+            return true;
+#else
+            static const bool supported = __builtin_cpu_supports("avx2");
+            return supported;
+#endif
+        }
+
+        // 32 字节掩码规整为 0x00 / 0xFF
+        SCORE_KERNELS_TARGET_AVX2 inline __m256i selection(const uint8_t* mask) {
+            __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mask));
+            return _mm256_xor_si256(_mm256_cmpeq_epi8(m, _mm256_setzero_si256()), _mm256_set1_epi8(-1));
+        }
+
+        // 4 个 64 位通道水平相加
+        SCORE_KERNELS_TARGET_AVX2 inline uint64_t horizontalSum(__m256i v) {
+            alignas(32) uint64_t lanes[4];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), v);
+            return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        }
+
+        SCORE_KERNELS_TARGET_AVX2 inline uint64_t sumAvx2(const uint8_t* scores, const uint8_t* mask, size_t n) {
+            size_t i = 0;
+            __m256i acc = _mm256_setzero_si256();
+            for (; i + 32 <= n; i += 32) {
+                __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(scores + i));
+                s = _mm256_and_si256(s, selection(mask + i));
+                acc = _mm256_add_epi64(acc, _mm256_sad_epu8(s, _mm256_setzero_si256()));
+            }
+            return horizontalSum(acc) + sumScalar(scores, mask, i, n);
+        }
+
+        SCORE_KERNELS_TARGET_AVX2 inline size_t countAtLeastAvx2(const uint8_t* scores, const uint8_t* mask,
+                                                                 size_t n, uint8_t threshold) {
+            size_t i = 0;
+            const __m256i limit = _mm256_set1_epi8(static_cast<char>(threshold));
+            const __m256i one = _mm256_set1_epi8(1);
+            __m256i acc = _mm256_setzero_si256();
+            for (; i + 32 <= n; i += 32) {
+                __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(scores + i));
+                __m256i atLeast = _mm256_cmpeq_epi8(_mm256_max_epu8(s, limit), s);
+                __m256i hit = _mm256_and_si256(_mm256_and_si256(atLeast, selection(mask + i)), one);
+                acc = _mm256_add_epi64(acc, _mm256_sad_epu8(hit, _mm256_setzero_si256()));
+            }
+            return static_cast<size_t>(horizontalSum(acc)) + countAtLeastScalar(scores, mask, i, n, threshold);
+        }
+
+        SCORE_KERNELS_TARGET_AVX2 inline void minMaxAvx2(const uint8_t* scores, const uint8_t* mask, size_t n,
+                                                         uint8_t& low, uint8_t& high, bool& found) {
+            size_t i = 0;
+            // 未选中的位置：求最小时视为 255，求最大时视为 0
+            __m256i lows = _mm256_set1_epi8(-1);
+            __m256i highs = _mm256_setzero_si256();
+            __m256i any = _mm256_setzero_si256();
+            for (; i + 32 <= n; i += 32) {
+                __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(scores + i));
+                __m256i sel = selection(mask + i);
+                lows = _mm256_min_epu8(lows, _mm256_or_si256(s, _mm256_andnot_si256(sel, _mm256_set1_epi8(-1))));
+                highs = _mm256_max_epu8(highs, _mm256_and_si256(s, sel));
+                any = _mm256_or_si256(any, sel);
+            }
+            alignas(32) uint8_t lowLanes[32];
+            alignas(32) uint8_t highLanes[32];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lowLanes), lows);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(highLanes), highs);
+            for (int lane = 0; lane < 32; ++lane) {
+                low = std::min(low, lowLanes[lane]);
+                high = std::max(high, highLanes[lane]);
+            }
+            found = !_mm256_testz_si256(any, any);
+            minMaxScalar(scores, mask, i, n, low, high, found);
+        }
+#endif
+    }
+
+    // 选中成绩的分数和
+    inline uint64_t sum(const uint8_t* scores, const uint8_t* mask, size_t n) {
+#ifdef SCORE_KERNELS_AVX2
+        if (detail::avx2Supported()) return detail::sumAvx2(scores, mask, n);
+#endif
+        return detail::sumScalar(scores, mask, 0, n);
+    }
+
+    // 选中且分数 >= threshold 的成绩数；threshold 为 0 时即选中数
+    inline size_t countAtLeast(const uint8_t* scores, const uint8_t* mask, size_t n, uint8_t threshold) {
+#ifdef SCORE_KERNELS_AVX2
+        if (detail::avx2Supported()) return detail::countAtLeastAvx2(scores, mask, n, threshold);
+#endif
+        return detail::countAtLeastScalar(scores, mask, 0, n, threshold);
+    }
+
+    // 选中成绩的 (最低分, 最高分)，没有选中时返回 nullopt
+    inline std::optional<std::pair<uint8_t, uint8_t>> minMax(const uint8_t* scores, const uint8_t* mask, size_t n) {
+        uint8_t low = 255;
+        uint8_t high = 0;
+        bool found = false;
+#ifdef SCORE_KERNELS_AVX2
+        if (detail::avx2Supported()) {
+            detail::minMaxAvx2(scores, mask, n, low, high, found);
+        } else {
+            detail::minMaxScalar(scores, mask, 0, n, low, high, found);
+        }
+#else
+        detail::minMaxScalar(scores, mask, 0, n, low, high, found);
+#endif
+        if (!found) return std::nullopt;
+        return std::make_pair(low, high);
+    }
+
+    // 选中成绩的直方图（累加到 histogram）
+    // 直方图没有合适的 SIMD 散射指令，改用四份子直方图交替累加，消除同一计数器上的写后读依赖
+    inline void histogram(const uint8_t* scores, const uint8_t* mask, size_t n, Histogram& histogram) {
+        std::array<Histogram, 4> partial{};
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            partial[0][scores[i]] += mask[i] != 0;
+            partial[1][scores[i + 1]] += mask[i + 1] != 0;
+            partial[2][scores[i + 2]] += mask[i + 2] != 0;
+            partial[3][scores[i + 3]] += mask[i + 3] != 0;
+        }
+        for (; i < n; ++i) partial[0][scores[i]] += mask[i] != 0;
+        for (int bin = 0; bin < BINS; ++bin) {
+            histogram[bin] += partial[0][bin] + partial[1][bin] + partial[2][bin] + partial[3][bin];
+        }
+    }
+}
+
+#endif // SCORE_KERNELS_H
@@ -0,0 +1,169 @@
+#ifndef SESSION_STORE_H
+#define SESSION_STORE_H
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <chrono>
+#include <sstream>
+#include <iomanip>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+#include "models.h"
+#include "permissions.h"
+
+// 内存会话索引：token -> 会话，userId -> 该用户的全部 token
+// 校验、登出为 O(1)，按用户吊销为 O(该用户的会话数)
+class SessionStore {
+private:
+    struct Session {
+        JWTToken token;
+        std::chrono::system_clock::time_point expires;
+        RoleMask roles; // 登录时解析的角色掩码
+    };
+
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string, Session> sessions;
+    std::unordered_map<std::string, std::unordered_set<std::string>> byUser;
+
+    void insertLocked(const JWTToken& token, RoleMask roles) {
+        sessions[token.token] = Session{token, parseTime(token.expiresAt), roles};
+        byUser[token.userId].insert(token.token);
+    }
+
+    void eraseFromUserLocked(const std::string& userId, const std::string& token) {
+        auto it = byUser.find(userId);
+        if (it == byUser.end()) return;
+        it->second.erase(token);
+        if (it->second.empty()) byUser.erase(it);
+    }
+
+public:
+    // 解析 ctime 格式时间（"Wed Jan 12 10:30:45 2026"，本地时间）
+    static std::chrono::system_clock::time_point parseTime(const std::string& text) {
+        std::tm tm = {};
+        std::istringstream ss(text);
+        ss >> std::get_time(&tm, "%a %b %d %H:%M:%S %Y");
+        tm.tm_isdst = -1;
+        return std::chrono::system_clock::from_time_t(std::mktime(&tm));
+    }
+
+    // 将 ctime 格式时间转换为 ISO 8601（UTC）
+    static std::string toISO8601(const std::string& text) {
+        std::time_t tt = std::chrono::system_clock::to_time_t(parseTime(text));
+        std::tm tm{};
+    #ifdef _WIN32
+        gmtime_s(&tm, &tt);
+    #else
+        gmtime_r(&tt, &tm);
+    #endif
+        char buf[32];
+        std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &tm);
+        return std::string(buf);
+    }
+
+    // 从持久化数据重建索引，roleOf 用于解析每个用户的角色掩码
+    void load(const std::vector<JWTToken>& tokens, const std::function<RoleMask(const std::string&)>& roleOf) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        sessions.clear();
+        byUser.clear();
+        for (const auto& token : tokens) {
+            insertLocked(token, roleOf(token.userId));
+        }
+    }
+
+    void add(const JWTToken& token, RoleMask roles) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        insertLocked(token, roles);
+    }
+
+    // 用户角色变更时同步更新其全部会话的角色掩码
+    void updateRoles(const std::string& userId, RoleMask roles) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        auto it = byUser.find(userId);
+        if (it == byUser.end()) return;
+        for (const auto& token : it->second) {
+            auto sIt = sessions.find(token);
+            if (sIt != sessions.end()) sIt->second.roles = roles;
+        }
+    }
+
+    // 删除单个会话
+    bool remove(const std::string& token) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        auto it = sessions.find(token);
+        if (it == sessions.end()) return false;
+        eraseFromUserLocked(it->second.token.userId, token);
+        sessions.erase(it);
+        return true;
+    }
+
+    // 吊销某用户的全部会话，返回吊销数量
+    size_t revokeUser(const std::string& userId) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        auto it = byUser.find(userId);
+        if (it == byUser.end()) return 0;
+        size_t count = it->second.size();
+        for (const auto& token : it->second) {
+            sessions.erase(token);
+        }
+        byUser.erase(it);
+        return count;
+    }
+
+    // 查找未过期的会话
+    std::optional<JWTToken> findValid(const std::string& token) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = sessions.find(token);
+        if (it == sessions.end()) return std::nullopt;
+        if (std::chrono::system_clock::now() >= it->second.expires) return std::nullopt;
+        return it->second.token;
+    }
+
+    // 获取未过期会话的角色掩码，无效或过期时返回 Role::NONE
+    RoleMask rolesOf(const std::string& token) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = sessions.find(token);
+        if (it == sessions.end()) return Role::NONE;
+        if (std::chrono::system_clock::now() >= it->second.expires) return Role::NONE;
+        return it->second.roles;
+    }
+
+    // 列出未过期的会话（可按用户过滤）
+    std::vector<JWTToken> activeSessions(const std::string& userId = "") const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto now = std::chrono::system_clock::now();
+        std::vector<JWTToken> result;
+        auto collect = [&](const std::string& token) {
+            auto it = sessions.find(token);
+            if (it != sessions.end() && now < it->second.expires) {
+                result.push_back(it->second.token);
+            }
+        };
+        if (!userId.empty()) {
+            auto it = byUser.find(userId);
+            if (it != byUser.end()) {
+                for (const auto& token : it->second) collect(token);
+            }
+        } else {
+            for (const auto& [token, session] : sessions) collect(token);
+        }
+        return result;
+    }
+
+    // 全部会话快照（用于持久化）
+    std::vector<JWTToken> snapshot() const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        std::vector<JWTToken> result;
+        result.reserve(sessions.size());
+        for (const auto& [token, session] : sessions) {
+            result.push_back(session.token);
+        }
+        return result;
+    }
+};
+
+#endif // SESSION_STORE_H
@@ -0,0 +1,207 @@
+#ifndef STATISTICS_MODELS_H
+#define STATISTICS_MODELS_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "grade_stats.h"
+
+using json = nlohmann::json;
+
+// 统计结果模型：StatisticsService 的计算函数返回这些结构，HTTP 接口与报表只负责序列化
+
+// 统计概览
+struct OverviewStatistics {
+    double avgScore = 0.0;
+    double passRate = 0.0;
+    int totalStudents = 0;
+    int totalCourses = 0;
+    int totalGrades = 0;
+
+    friend void to_json(json& j, const OverviewStatistics& s) {
+        j = json{
+            {"avgScore", s.avgScore},
+            {"passRate", s.passRate},
+            {"totalStudents", s.totalStudents},
+            {"totalCourses", s.totalCourses},
+            {"totalGrades", s.totalGrades}
+        };
+    }
+};
+
+// 班级内按最高分排名的学生
+struct ClassTopStudent {
+    std::string studentId;
+    std::string name;
+    int score = 0;
+
+    friend void to_json(json& j, const ClassTopStudent& s) {
+        j = json{
+            {"studentId", s.studentId},
+            {"name", s.name},
+            {"score", s.score}
+        };
+    }
+};
+
+// 班级统计
+struct ClassStatistics {
+    std::string className;
+    double avgScore = 0.0;
+    double passRate = 0.0;
+    int totalStudents = 0;
+    std::vector<ClassTopStudent> topStudents;
+
+    friend void to_json(json& j, const ClassStatistics& s) {
+        j = json{
+            {"class", s.className},
+            {"avgScore", s.avgScore},
+            {"passRate", s.passRate},
+            {"totalStudents", s.totalStudents},
+            {"topStudents", s.topStudents}
+        };
+    }
+};
+
+// 课程统计（没有成绩时各项为 0）
+struct CourseStatistics {
+    std::string courseId;
+    std::string courseName;
+    double avgScore = 0.0;
+    double passRate = 0.0;
+    int totalStudents = 0;
+    int highestScore = 0;
+    int lowestScore = 0;
+
+    friend void to_json(json& j, const CourseStatistics& s) {
+        j = json{
+            {"courseId", s.courseId},
+            {"courseName", s.courseName},
+            {"avgScore", s.avgScore},
+            {"passRate", s.passRate},
+            {"totalStudents", s.totalStudents},
+            {"highestScore", s.highestScore},
+            {"lowestScore", s.lowestScore}
+        };
+    }
+};
+
+// 平均分排行中的学生
+struct LeaderboardEntry {
+    int rank = 0;
+    std::string studentId;
+    std::string name;
+    std::string className;
+    double avgScore = 0.0;
+
+    friend void to_json(json& j, const LeaderboardEntry& e) {
+        j = json{
+            {"rank", e.rank},
+            {"studentId", e.studentId},
+            {"name", e.name},
+            {"class", e.className},
+            {"avgScore", e.avgScore}
+        };
+    }
+};
+
+// 学生成绩汇总
+struct StudentStatistics {
+    std::string studentId;
+    std::string studentName;
+    std::string className;
+    int totalCourses = 0;
+    double avgScore = 0.0;
+    double passRate = 0.0;
+    int64_t totalScore = 0;
+
+    friend void to_json(json& j, const StudentStatistics& s) {
+        j = json{
+            {"studentId", s.studentId},
+            {"studentName", s.studentName},
+            {"className", s.className},
+            {"totalCourses", s.totalCourses},
+            {"avgScore", s.avgScore},
+            {"passRate", s.passRate},
+            {"totalScore", s.totalScore}
+        };
+    }
+};
+
+// 分数段人数
+struct BucketCount {
+    ScoreRange range;
+    int count = 0;
+    double percentage = 0.0;
+
+    friend void to_json(json& j, const BucketCount& b) {
+        j = json{
+            {"range", b.range.label()},
+            {"count", b.count},
+            {"percentage", b.percentage}
+        };
+    }
+};
+
+// 分位数统计
+struct PercentileStatistics {
+    std::string courseId;
+    std::string className;
+    int count = 0;
+    double avgScore = 0.0;
+    double median = 0.0;
+    double q1 = 0.0;
+    double q3 = 0.0;
+    double stddev = 0.0;
+    int highestScore = 0;
+    int lowestScore = 0;
+    std::vector<std::pair<double, double>> percentiles;   // (分位点 0–100, 分数)
+    std::optional<std::pair<int, double>> percentileRank; // (分数, 百分位等级)
+
+    friend void to_json(json& j, const PercentileStatistics& s) {
+        json points = json::array();
+        for (const auto& [percentile, value] : s.percentiles) {
+            points.push_back({{"percentile", percentile}, {"value", value}});
+        }
+        j = json{
+            {"courseId", s.courseId},
+            {"class", s.className},
+            {"count", s.count},
+            {"avgScore", s.avgScore},
+            {"median", s.median},
+            {"q1", s.q1},
+            {"q3", s.q3},
+            {"stddev", s.stddev},
+            {"highestScore", s.highestScore},
+            {"lowestScore", s.lowestScore},
+            {"percentiles", points}
+        };
+        if (s.percentileRank.has_value()) {
+            j["percentileRank"] = {
+                {"score", s.percentileRank->first},
+                {"rank", s.percentileRank->second}
+            };
+        }
+    }
+};
+
+// 批量统计的范围：overall / course / class / student / cell（班级×课程）
+struct StatisticsScope {
+    std::string type;
+    std::string id;        // course / class / student：课程ID、班级名或学号
+    std::string className; // cell
+    std::string courseId;  // cell
+};
+
+// 一个范围的累计量；found 为 false 表示课程、班级或学生不存在
+struct ScopeStatistics {
+    StatisticsScope scope;
+    bool found = false;
+    std::string name;      // 课程名称或学生姓名
+    ScoreStats stats;
+};
+
+#endif // STATISTICS_MODELS_H
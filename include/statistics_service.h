@@ -7,20 +7,29 @@
 #include <crow.h>
 #include <algorithm>
 #include <numeric>
+#include <sstream>
+#include <unordered_map>
+#include <tuple>
 #include "models.h"
 #include "data_manager.h"
 #include "auth.h"
 #include "middleware.h"
+#include "top_k.h"
+#include "parallel_scan.h"
+#include "stats_cache.h"
+#include "statistics_models.h"
 
 class StatisticsService {
 private:
     DataManager* dataManager;
     AuthManager* authManager;
     LogMiddleware* logger;
+    ParallelScan scanner; // 无法由累计量回答的临时筛选，在共享线程池中分区扫描
+    StatsCache cache;     // 统计结果缓存，按所依赖范围的版本号校验
 
 public:
-    StatisticsService(DataManager* dm, AuthManager* am, LogMiddleware* log) 
-        : dataManager(dm), authManager(am), logger(log) {}
+    StatisticsService(DataManager* dm, AuthManager* am, LogMiddleware* log, ThreadPool* pool) 
+        : dataManager(dm), authManager(am), logger(log), scanner(*pool) {}
 
     // 获取统计概览
     crow::response getOverview(const crow::request& req) {
@@ -34,33 +43,11 @@ public:
             return errorResponse("Unauthorized", "Invalid token", 401);
         }
 
-        auto students = dataManager->getStudents();
-        auto courses = dataManager->getCourses();
-        auto grades = dataManager->getGrades();
-
-        // 计算统计信息
-        double avgScore = 0.0;
-        double passRate = 0.0;
-        int totalGrades = grades.size();
-
-        if (totalGrades > 0) {
-            int totalScore = 0;
-            int passCount = 0;
-            for (const auto& grade : grades) {
-                totalScore += grade.score;
-                if (grade.score >= 60) passCount++;
-            }
-            avgScore = static_cast<double>(totalScore) / totalGrades;
-            passRate = (static_cast<double>(passCount) / totalGrades) * 100.0;
-        }
-
-        json result = {
-            {"avgScore", avgScore},
-            {"passRate", passRate},
-            {"totalStudents", static_cast<int>(students.size())},
-            {"totalCourses", static_cast<int>(courses.size())},
-            {"totalGrades", totalGrades}
-        };
+        // 直接读取全局累计量，不读取数据文件；概览依赖全部三个集合
+        auto versions = dataManager->versions();
+        crow::response res = cached(StatsCache::key("overview", {}),
+            {versions.grades, versions.students, versions.courses},
+            [&] { return jsonResponse(json(overviewStatistics())); });
 
         // 记录日志
         auto currentUser = authManager->getCurrentUser(token.substr(7));
@@ -69,7 +56,7 @@ public:
                                "GET /statistics/overview", "统计分析");
         }
 
-        return jsonResponse(result);
+        return res;
     }
 
     // 按班级统计
@@ -85,102 +72,17 @@ public:
         }
 
         // 获取查询参数
-        std::string classFilter = "";
-        std::string courseId = "";
-
-        auto students = dataManager->getStudents();
-        auto grades = dataManager->getGrades();
-
-        // 获取所有班级
-        std::vector<std::string> classes;
-        for (const auto& student : students) {
-            if (std::find(classes.begin(), classes.end(), student.className) == classes.end()) {
-                classes.push_back(student.className);
-            }
-        }
-
-        // 筛选特定班级
-        if (!classFilter.empty()) {
-            classes = {classFilter};
+        std::string classFilter = req.get_header_value("X-Query-Class");
+        auto topK = parseTopK(req, 3);
+        if (!topK.has_value()) {
+            return errorResponse("BadRequest", "Invalid k", 400);
         }
 
-        json result = json::array();
-
-        for (const auto& className : classes) {
-            // 获取该班级所有学生
-            std::vector<std::string> studentIds;
-            for (const auto& student : students) {
-                if (student.className == className) {
-                    studentIds.push_back(student.studentId);
-                }
-            }
-
-            // 获取该班级所有成绩
-            std::vector<Grade> classGrades;
-            for (const auto& grade : grades) {
-                if (std::find(studentIds.begin(), studentIds.end(), grade.studentId) != studentIds.end()) {
-                    if (courseId.empty() || grade.courseId == courseId) {
-                        classGrades.push_back(grade);
-                    }
-                }
-            }
-
-            if (classGrades.empty()) continue;
-
-            // 计算统计
-            int totalScore = 0;
-            int passCount = 0;
-            for (const auto& grade : classGrades) {
-                totalScore += grade.score;
-                if (grade.score >= 60) passCount++;
-            }
-
-            double avgScore = static_cast<double>(totalScore) / classGrades.size();
-            double passRate = (static_cast<double>(passCount) / classGrades.size()) * 100.0;
-
-            // 获取前3名
-            std::vector<std::pair<std::string, int>> studentScores;
-            for (const auto& grade : classGrades) {
-                studentScores.push_back({grade.studentId, grade.score});
-            }
-            
-            // 按成绩排序
-            std::sort(studentScores.begin(), studentScores.end(),
-                [](const auto& a, const auto& b) { return a.second > b.second; });
-
-            // 去重，只保留每个学生最高分
-            std::vector<std::pair<std::string, int>> topScores;
-            std::vector<std::string> processed;
-            for (const auto& score : studentScores) {
-                if (std::find(processed.begin(), processed.end(), score.first) == processed.end()) {
-                    topScores.push_back(score);
-                    processed.push_back(score.first);
-                    if (topScores.size() >= 3) break;
-                }
-            }
-
-            // 构建topStudents
-            json topStudents = json::array();
-            for (const auto& score : topScores) {
-                auto studentIt = std::find_if(students.begin(), students.end(),
-                    [&](const Student& s) { return s.studentId == score.first; });
-                if (studentIt != students.end()) {
-                    topStudents.push_back({
-                        {"studentId", score.first},
-                        {"name", studentIt->name},
-                        {"score", score.second}
-                    });
-                }
-            }
-
-            result.push_back({
-                {"class", className},
-                {"avgScore", avgScore},
-                {"passRate", passRate},
-                {"totalStudents", static_cast<int>(studentIds.size())},
-                {"topStudents", topStudents}
-            });
-        }
+        // 结果依赖该班级（不筛选时为全部成绩）与学生名单
+        StatsCache::Stamp stamp = scopeStamp("", classFilter);
+        stamp.push_back(dataManager->versions().students);
+        crow::response res = cached(StatsCache::key("class", {classFilter, std::to_string(topK.value())}), stamp,
+            [&] { return jsonResponse(json(classStatistics(classFilter, topK.value()))); });
 
         // 记录日志
         auto currentUser = authManager->getCurrentUser(token.substr(7));
@@ -189,7 +91,7 @@ public:
                                "GET /statistics/class", "统计分析");
         }
 
-        return jsonResponse(result);
+        return res;
     }
 
     // 按课程统计
@@ -205,78 +107,22 @@ public:
         }
 
         // 获取查询参数
-        std::string courseId = "";
+        std::string courseId = req.get_header_value("X-Query-CourseId");
 
         if (courseId.empty()) {
             return errorResponse("BadRequest", "courseId is required", 400);
         }
 
-        // 检查课程是否存在
-        auto courses = dataManager->getCourses();
-        auto courseIt = std::find_if(courses.begin(), courses.end(),
-            [&](const Course& c) { return c.courseId == courseId; });
-        
-        if (courseIt == courses.end()) {
-            return errorResponse("NotFound", "Course not found", 404);
-        }
-
-        auto grades = dataManager->getGrades();
-        auto students = dataManager->getStudents();
-
-        // 获取该课程所有成绩
-        std::vector<Grade> courseGrades;
-        for (const auto& grade : grades) {
-            if (grade.courseId == courseId) {
-                courseGrades.push_back(grade);
-            }
-        }
-
-        if (courseGrades.empty()) {
-            json result = {
-                {"courseId", courseId},
-                {"courseName", courseIt->name},
-                {"avgScore", 0.0},
-                {"passRate", 0.0},
-                {"totalStudents", 0},
-                {"highestScore", 0},
-                {"lowestScore", 0}
-            };
-            return jsonResponse(result);
-        }
-
-        // 计算统计
-        int totalScore = 0;
-        int passCount = 0;
-        int highestScore = 0;
-        int lowestScore = 100;
-
-        for (const auto& grade : courseGrades) {
-            totalScore += grade.score;
-            if (grade.score >= 60) passCount++;
-            if (grade.score > highestScore) highestScore = grade.score;
-            if (grade.score < lowestScore) lowestScore = grade.score;
-        }
-
-        double avgScore = static_cast<double>(totalScore) / courseGrades.size();
-        double passRate = (static_cast<double>(passCount) / courseGrades.size()) * 100.0;
-
-        // 统计去重后的学生数量
-        std::vector<std::string> studentIds;
-        for (const auto& grade : courseGrades) {
-            if (std::find(studentIds.begin(), studentIds.end(), grade.studentId) == studentIds.end()) {
-                studentIds.push_back(grade.studentId);
+        // 结果依赖该课程的成绩与课程列表
+        StatsCache::Stamp stamp = scopeStamp(courseId, "");
+        stamp.push_back(dataManager->versions().courses);
+        crow::response res = cached(StatsCache::key("course", {courseId}), stamp, [&] {
+            auto result = courseStatistics(courseId);
+            if (!result.has_value()) {
+                return errorResponse("NotFound", "Course not found", 404);
             }
-        }
-
-        json result = {
-            {"courseId", courseId},
-            {"courseName", courseIt->name},
-            {"avgScore", avgScore},
-            {"passRate", passRate},
-            {"totalStudents", static_cast<int>(studentIds.size())},
-            {"highestScore", highestScore},
-            {"lowestScore", lowestScore}
-        };
+            return jsonResponse(json(result.value()));
+        });
 
         // 记录日志
         auto currentUser = authManager->getCurrentUser(token.substr(7));
@@ -285,7 +131,7 @@ public:
                                "GET /statistics/course", "统计分析");
         }
 
-        return jsonResponse(result);
+        return res;
     }
 
     // 获取排名列表
@@ -300,8 +146,10 @@ public:
             return errorResponse("Unauthorized", "Invalid token", 401);
         }
 
-        // 解析分页参数（支持字符串和整数）
-        auto [page, limit] = parsePaginationParams(req, 1, 10, 1000);
+        // 解析分页参数（支持字符串和整数；结构化绑定不能被 lambda 捕获，故拆成普通变量）
+        auto pagination = parsePaginationParams(req, 1, 10, 1000);
+        int page = pagination.first;
+        int limit = pagination.second;
         
         // 获取过滤参数
         std::string classFilter = req.get_header_value("X-Query-Class");
@@ -311,113 +159,121 @@ public:
         bool fullData = requestFullData(req);
         std::vector<std::string> fields = parseFieldsParam(req);
 
-        auto students = dataManager->getStudents();
-        auto grades = dataManager->getGrades();
+        // 结果依赖所筛选的课程/班级（不筛选时为全部成绩）与学生名单；字段顺序不影响结果
+        std::vector<std::string> sortedFields = fields;
+        std::sort(sortedFields.begin(), sortedFields.end());
+        std::string fieldsKey;
+        for (const auto& field : sortedFields) fieldsKey += field + ",";
+        StatsCache::Stamp stamp = scopeStamp(courseId, classFilter);
+        stamp.push_back(dataManager->versions().students);
+        std::optional<int> computedTotal; // 未命中缓存时的总人数，用于日志
+        crow::response res = cached(StatsCache::key("ranking",
+                {std::to_string(page), std::to_string(limit), classFilter, courseId, fieldsKey}), stamp, [&] {
+            auto students = dataManager->getStudents();
 
-        // 计算每个学生的总成绩和平均分
-        std::map<std::string, std::vector<int>> studentScores;
-        
-        for (const auto& grade : grades) {
-            // 筛选课程
-            if (!courseId.empty() && grade.courseId != courseId) continue;
-            
-            // 筛选班级
-            if (!classFilter.empty()) {
-                auto studentIt = std::find_if(students.begin(), students.end(),
-                    [&](const Student& s) { return s.studentId == grade.studentId; });
-                if (studentIt == students.end() || studentIt->className != classFilter) continue;
+            // 学号 -> 学生，避免逐条线性查找
+            std::unordered_map<std::string, const Student*> studentById;
+            for (const auto& student : students) {
+                studentById.emplace(student.studentId, &student);
             }
 
-            studentScores[grade.studentId].push_back(grade.score);
-        }
-
-        // 计算排名数据
-        struct RankData {
-            std::string studentId;
-            std::string name;
-            std::string className;
-            double avgScore;
-            int totalScore;
-            int courseCount;
-        };
-
-        std::vector<RankData> rankings;
-
-        for (const auto& [studentId, scores] : studentScores) {
-            if (scores.empty()) continue;
+            // 计算每个学生的总成绩和课程数：在内存列式成绩上分区并行累计，局部结果按学生编号相加
+            // 找不到学生信息的成绩不参与排名（由选择掩码排除）
+            struct StudentTotals {
+                std::vector<int64_t> totals;  // 学生编号 -> 总分
+                std::vector<uint32_t> counts; // 学生编号 -> 课程数
+            };
+            using ScoreTotals = std::unordered_map<std::string, std::pair<int, int>>;
+            ScoreTotals studentScores;
+            dataManager->statistics().scanColumns(courseId, classFilter, [&](const GradeStatsIndex::ColumnsView& columns) {
+                size_t studentCount = columns.studentCount();
+                StudentTotals sums = scanner.reduce(columns.rows,
+                    StudentTotals{std::vector<int64_t>(studentCount), std::vector<uint32_t>(studentCount)},
+                    [&](StudentTotals& partial, size_t begin, size_t end) {
+                        std::vector<uint8_t> mask(end - begin);
+                        columns.select(begin, end, mask.data());
+                        for (size_t i = begin; i < end; ++i) {
+                            if (!mask[i - begin]) continue;
+                            partial.totals[columns.students[i]] += columns.scores[i];
+                            partial.counts[columns.students[i]]++;
+                        }
+                    },
+                    [](StudentTotals& result, StudentTotals&& partial) {
+                        for (size_t key = 0; key < result.totals.size(); ++key) {
+                            result.totals[key] += partial.totals[key];
+                            result.counts[key] += partial.counts[key];
+                        }
+                    });
+                for (size_t key = 0; key < studentCount; ++key) {
+                    if (sums.counts[key] == 0) continue;
+                    const std::string& studentId = *(*columns.studentIds)[key];
+                    if (studentById.count(studentId) == 0) continue;
+                    studentScores.emplace(studentId, std::make_pair(static_cast<int>(sums.totals[key]),
+                                                                    static_cast<int>(sums.counts[key])));
+                }
+            });
 
-            int totalScore = std::accumulate(scores.begin(), scores.end(), 0);
-            double avgScore = static_cast<double>(totalScore) / scores.size();
+            // 分页：只需前 page*limit 名，用有界堆按平均分取出后截取本页
+            int total = studentScores.size();
+            computedTotal = total;
+            int start = (page - 1) * limit;
+            int end = std::min(start + limit, total);
 
-            // 查找学生信息
-            auto studentIt = std::find_if(students.begin(), students.end(),
-                [&](const Student& s) { return s.studentId == studentId; });
-            
-            if (studentIt != students.end()) {
-                rankings.push_back({
-                    studentId,
-                    studentIt->name,
-                    studentIt->className,
-                    avgScore,
-                    totalScore,
-                    static_cast<int>(scores.size())
-                });
+            TopK<std::string, double> leaders(start < total ? static_cast<size_t>(end) : 0);
+            for (const auto& [studentId, score] : studentScores) {
+                leaders.offer(studentId, static_cast<double>(score.first) / score.second);
             }
-        }
-
-        // 按平均分排序
-        std::sort(rankings.begin(), rankings.end(),
-            [](const RankData& a, const RankData& b) { return a.avgScore > b.avgScore; });
-
-        // 分页
-        int total = rankings.size();
-        int start = (page - 1) * limit;
-        int end = std::min(start + limit, total);
-        
-        // 构建结果
-        json result = json::array();
-        if (start < total) {
-            for (int i = start; i < end; i++) {
-                json item = {
-                    {"rank", i + 1},
-                    {"studentId", rankings[i].studentId},
-                    {"name", rankings[i].name},
-                    {"class", rankings[i].className},
-                    {"totalScore", rankings[i].totalScore},
-                    {"avgScore", rankings[i].avgScore},
-                    {"courseCount", rankings[i].courseCount}
-                };
-                
-                // 如果指定了fields，进行字段过滤
-                if (!fields.empty()) {
-                    json filteredItem;
-                    for (const auto& field : fields) {
-                        if (item.contains(field)) {
-                            filteredItem[field] = item[field];
+            auto ranked = leaders.sorted();
+            
+            // 构建结果
+            json result = json::array();
+            if (start < total) {
+                for (int i = start; i < end; i++) {
+                    const auto& [studentId, avgScore] = ranked[i];
+                    const Student* student = studentById.at(studentId);
+                    const auto& score = studentScores.at(studentId);
+                    json item = {
+                        {"rank", i + 1},
+                        {"studentId", studentId},
+                        {"name", student->name},
+                        {"class", student->className},
+                        {"totalScore", score.first},
+                        {"avgScore", avgScore},
+                        {"courseCount", score.second}
+                    };
+                    
+                    // 如果指定了fields，进行字段过滤
+                    if (!fields.empty()) {
+                        json filteredItem;
+                        for (const auto& field : fields) {
+                            if (item.contains(field)) {
+                                filteredItem[field] = item[field];
+                            }
                         }
+                        result.push_back(filteredItem);
+                    } else {
+                        result.push_back(item);
                     }
-                    result.push_back(filteredItem);
-                } else {
-                    result.push_back(item);
                 }
             }
-        }
-        
-        // 包装成分页格式
-        json response = {
-            {"data", result},
-            {"total", total},
-            {"page", page},
-            {"limit", limit},
-            {"totalPages", (total + limit - 1) / limit}
-        };
+            
+            // 包装成分页格式
+            json response = {
+                {"data", result},
+                {"total", total},
+                {"page", page},
+                {"limit", limit},
+                {"totalPages", (total + limit - 1) / limit}
+            };
+            return jsonResponse(response);
+        });
 
         // 记录日志（包含分页参数）
         auto currentUser = authManager->getCurrentUser(token.substr(7));
         if (currentUser.has_value()) {
             std::string logMsg = "GET /statistics/ranking | page=" + std::to_string(page) + 
                                ", limit=" + std::to_string(limit) + 
-                               ", total=" + std::to_string(total);
+                               (computedTotal.has_value() ? ", total=" + std::to_string(computedTotal.value()) : ", cached");
             if (!fields.empty()) {
                 logMsg += ", fields=" + std::to_string(fields.size());
             }
@@ -425,7 +281,7 @@ public:
                                logMsg, "统计分析");
         }
 
-        return jsonResponse(response);
+        return res;
     }
 
     // 获取成绩分布
@@ -444,63 +300,262 @@ public:
         std::string courseId = req.get_header_value("X-Query-CourseId");
         std::string classFilter = req.get_header_value("X-Query-Class");
 
-        auto grades = dataManager->getGrades();
-        auto students = dataManager->getStudents();
+        // 分数段布局：default / deciles / 分割点 / 显式区间
+        auto ranges = ScoreBuckets::parse(req.get_header_value("X-Query-Buckets"));
+        if (!ranges.has_value()) {
+            return errorResponse("BadRequest", "Invalid buckets", 400);
+        }
 
-        // 筛选
-        std::vector<Grade> filtered;
-        for (const auto& grade : grades) {
-            if (!courseId.empty() && grade.courseId != courseId) continue;
-            
-            if (!classFilter.empty()) {
-                auto studentIt = std::find_if(students.begin(), students.end(),
-                    [&](const Student& s) { return s.studentId == grade.studentId; });
-                if (studentIt == students.end() || studentIt->className != classFilter) continue;
-            }
+        // 不同写法的同一组分数段共用缓存
+        std::string bucketsKey;
+        for (const auto& range : ranges.value()) bucketsKey += range.label() + ",";
+        crow::response res = cached(StatsCache::key("distribution", {courseId, classFilter, bucketsKey}),
+            scopeStamp(courseId, classFilter), [&] {
+            return jsonResponse(json(distribution(courseId, classFilter, ranges.value())));
+        });
 
-            filtered.push_back(grade);
+        // 记录日志
+        auto currentUser = authManager->getCurrentUser(token.substr(7));
+        if (currentUser.has_value()) {
+            logger->logOperation(currentUser.value().id, currentUser.value().username,
+                               "GET /statistics/distribution", "统计分析");
         }
 
-        // 定义分数段
-        struct ScoreRange {
-            std::string range;
-            int min;
-            int max;
-        };
+        return res;
+    }
 
-        std::vector<ScoreRange> ranges = {
-            {"90-100", 90, 100},
-            {"80-89", 80, 89},
-            {"70-79", 70, 79},
-            {"60-69", 60, 69},
-            {"0-59", 0, 59}
-        };
+    // 分位数统计：中位数、四分位数、标准差、指定分位数与百分位等级
+    crow::response getPercentiles(const crow::request& req) {
+        // 验证Token
+        auto token = req.get_header_value("Authorization");
+        if (token.empty() || token.substr(0, 7) != "Bearer ") {
+            return errorResponse("Unauthorized", "Missing token", 401);
+        }
+        
+        if (!authManager->verifyToken(token.substr(7))) {
+            return errorResponse("Unauthorized", "Invalid token", 401);
+        }
 
-        int total = filtered.size();
-        json result = json::array();
+        // 获取过滤参数（都不传时为全部成绩）
+        std::string courseId = req.get_header_value("X-Query-CourseId");
+        std::string classFilter = req.get_header_value("X-Query-Class");
 
-        for (const auto& range : ranges) {
-            int count = 0;
-            for (const auto& grade : filtered) {
-                if (grade.score >= range.min && grade.score <= range.max) {
-                    count++;
+        // 额外的分位点，如 "10,90"（0–100）
+        std::vector<double> points;
+        std::string pointsParam = req.get_header_value("X-Query-Percentiles");
+        if (!pointsParam.empty()) {
+            std::stringstream ss(pointsParam);
+            std::string item;
+            while (std::getline(ss, item, ',')) {
+                try {
+                    size_t used = 0;
+                    double p = std::stod(item, &used);
+                    if (used != item.size() || p < 0 || p > 100) throw std::invalid_argument(item);
+                    points.push_back(p);
+                } catch (...) {
+                    return errorResponse("BadRequest", "Invalid percentiles", 400);
                 }
             }
+        }
 
-            double percentage = total > 0 ? (static_cast<double>(count) / total) * 100.0 : 0.0;
+        // 计算百分位等级的分数（可选）
+        std::optional<int> rankScore;
+        std::string scoreParam = req.get_header_value("X-Query-Score");
+        if (!scoreParam.empty()) {
+            rankScore = ScoreBuckets::parseScore(scoreParam);
+            if (!rankScore.has_value()) {
+                return errorResponse("BadRequest", "Invalid score", 400);
+            }
+        }
+
+        std::string pointsKey;
+        for (double p : points) pointsKey += std::to_string(p) + ",";
+        crow::response res = cached(StatsCache::key("percentiles",
+                {courseId, classFilter, pointsKey, rankScore.has_value() ? std::to_string(rankScore.value()) : ""}),
+            scopeStamp(courseId, classFilter), [&] {
+            return jsonResponse(json(percentiles(courseId, classFilter, points, rankScore)));
+        });
+
+        // 记录日志
+        auto currentUser = authManager->getCurrentUser(token.substr(7));
+        if (currentUser.has_value()) {
+            logger->logOperation(currentUser.value().id, currentUser.value().username,
+                               "GET /statistics/percentiles", "统计分析");
+        }
+
+        return res;
+    }
+
+    // 班级×课程统计立方体切片：指定班级为该班各课程，指定课程为该课程各班级，都不指定为全部
+    crow::response getCube(const crow::request& req) {
+        // 验证Token
+        auto token = req.get_header_value("Authorization");
+        if (token.empty() || token.substr(0, 7) != "Bearer ") {
+            return errorResponse("Unauthorized", "Missing token", 401);
+        }
+        
+        if (!authManager->verifyToken(token.substr(7))) {
+            return errorResponse("Unauthorized", "Invalid token", 401);
+        }
 
-            result.push_back({
-                {"range", range.range},
-                {"count", count},
-                {"percentage", percentage}
+        // 获取过滤参数
+        std::string classFilter = req.get_header_value("X-Query-Class");
+        std::string courseId = req.get_header_value("X-Query-CourseId");
+
+        // 结果依赖所选范围以及学生名单（班级顺序）与课程列表（课程名称）
+        StatsCache::Stamp stamp = scopeStamp(courseId, classFilter);
+        auto versions = dataManager->versions();
+        stamp.push_back(versions.students);
+        stamp.push_back(versions.courses);
+        crow::response res = cached(StatsCache::key("cube", {classFilter, courseId}), stamp, [&] {
+            auto courses = dataManager->getCourses();
+            std::unordered_map<std::string, size_t> courseOrder;
+            for (size_t i = 0; i < courses.size(); ++i) courseOrder.emplace(courses[i].courseId, i);
+
+            if (!courseId.empty() && courseOrder.count(courseId) == 0) {
+                return errorResponse("NotFound", "Course not found", 404);
+            }
+
+            const auto& stats = dataManager->statistics();
+            std::unordered_map<std::string, size_t> classOrder;
+            json classes = json::array();
+            for (const auto& className : stats.classes()) {
+                if (!classFilter.empty() && className != classFilter) continue;
+                classOrder.emplace(className, classOrder.size());
+                classes.push_back(className);
+            }
+
+            // 每格直接取自立方体累计量；按班级（学生文件顺序）、课程（课程文件顺序）排列
+            auto cells = stats.cube(classFilter, courseId);
+            auto position = [&](const GradeStatsIndex::CubeCell& cell) {
+                auto cls = classOrder.find(cell.className);
+                auto course = courseOrder.find(cell.courseId);
+                return std::make_pair(cls == classOrder.end() ? classOrder.size() : cls->second,
+                                      course == courseOrder.end() ? courseOrder.size() : course->second);
+            };
+            std::sort(cells.begin(), cells.end(), [&](const auto& a, const auto& b) {
+                auto pa = position(a);
+                auto pb = position(b);
+                if (pa != pb) return pa < pb;
+                return std::tie(a.className, a.courseId) < std::tie(b.className, b.courseId);
             });
+
+            json courseList = json::array();
+            for (const auto& course : courses) {
+                if (!courseId.empty() && course.courseId != courseId) continue;
+                courseList.push_back({{"courseId", course.courseId}, {"courseName", course.name}});
+            }
+
+            json items = json::array();
+            for (const auto& cell : cells) {
+                items.push_back({
+                    {"class", cell.className},
+                    {"courseId", cell.courseId},
+                    {"count", static_cast<int>(cell.stats.count)},
+                    {"avgScore", cell.stats.average()},
+                    {"passRate", cell.stats.passRate()},
+                    {"highestScore", cell.stats.highest()},
+                    {"lowestScore", cell.stats.lowest()}
+                });
+            }
+
+            json result = {
+                {"classes", classes},
+                {"courses", courseList},
+                {"cells", items}
+            };
+            return jsonResponse(result);
+        });
+
+        // 记录日志
+        auto currentUser = authManager->getCurrentUser(token.substr(7));
+        if (currentUser.has_value()) {
+            logger->logOperation(currentUser.value().id, currentUser.value().username,
+                               "GET /statistics/cube", "统计分析");
+        }
+
+        return res;
+    }
+
+    // 批量统计：一次请求计算多个课程/班级/学生范围的指定指标，只认证一次、记录一条日志
+    crow::response getBatchStatistics(const crow::request& req) {
+        // 验证Token
+        auto token = req.get_header_value("Authorization");
+        if (token.empty() || token.substr(0, 7) != "Bearer ") {
+            return errorResponse("Unauthorized", "Missing token", 401);
+        }
+        
+        if (!authManager->verifyToken(token.substr(7))) {
+            return errorResponse("Unauthorized", "Invalid token", 401);
+        }
+
+        // 解析请求体
+        json body;
+        try {
+            body = json::parse(req.body);
+        } catch (...) {
+            return errorResponse("BadRequest", "Invalid JSON", 400);
+        }
+
+        if (!body.is_object() || !body.contains("scopes") || !body["scopes"].is_array()) {
+            return errorResponse("BadRequest", "Expected {scopes: [...], metrics: [...]}", 400);
+        }
+        const json& scopesArray = body["scopes"];
+        if (scopesArray.size() > MAX_BATCH_SCOPES) {
+            return errorResponse("BadRequest", "Too many scopes (max " + std::to_string(MAX_BATCH_SCOPES) + ")", 400);
+        }
+
+        // 指标：缺省为计数、平均分、及格率、最高分、最低分
+        std::vector<std::string> metrics = {"count", "avgScore", "passRate", "highestScore", "lowestScore"};
+        if (body.contains("metrics")) {
+            if (!body["metrics"].is_array() || body["metrics"].empty()) {
+                return errorResponse("BadRequest", "metrics must be a non-empty array", 400);
+            }
+            metrics.clear();
+            for (const auto& metric : body["metrics"]) {
+                if (!metric.is_string() || !metricValue(metric.get<std::string>(), ScoreStats{}).has_value()) {
+                    return errorResponse("BadRequest", "Unknown metric: " + metric.dump(), 400);
+                }
+                metrics.push_back(metric.get<std::string>());
+            }
         }
 
+        std::vector<StatisticsScope> scopes;
+        for (size_t i = 0; i < scopesArray.size(); ++i) {
+            auto scope = parseScope(scopesArray[i]);
+            if (!scope.has_value()) {
+                return errorResponse("BadRequest", "Invalid scope at index " + std::to_string(i), 400);
+            }
+            scopes.push_back(std::move(scope.value()));
+        }
+
+        json results = json::array();
+        for (const auto& item : scopeStatistics(scopes)) {
+            json entry = {{"type", item.scope.type}};
+            if (item.scope.type == "cell") {
+                entry["class"] = item.scope.className;
+                entry["courseId"] = item.scope.courseId;
+            } else if (item.scope.type != "overall") {
+                entry["id"] = item.scope.id;
+            }
+            entry["found"] = item.found;
+            if (!item.name.empty()) entry["name"] = item.name;
+            if (item.found) {
+                for (const auto& metric : metrics) entry[metric] = metricValue(metric, item.stats).value();
+            }
+            results.push_back(std::move(entry));
+        }
+
+        json result = {
+            {"metrics", metrics},
+            {"results", results}
+        };
+
         // 记录日志
         auto currentUser = authManager->getCurrentUser(token.substr(7));
         if (currentUser.has_value()) {
             logger->logOperation(currentUser.value().id, currentUser.value().username,
-                               "GET /statistics/distribution", "统计分析");
+                               "POST /statistics/batch | scopes=" + std::to_string(scopes.size()), "统计分析");
         }
 
         return jsonResponse(result);
@@ -518,136 +573,68 @@ public:
             return errorResponse("Unauthorized", "Invalid token", 401);
         }
 
-        // 获取查询参数
-        std::string type = "";
-        std::string format = "";
-        std::string classFilter = "";
-        std::string courseId = "";
-        std::string studentId = "";
-        std::string semester = "";
+        // 获取查询参数（URL 参数）
+        std::string type = urlParam(req, "type");
+        std::string format = urlParam(req, "format");
+        std::string classFilter = urlParam(req, "class");
+        std::string courseId = urlParam(req, "courseId");
+        std::string studentId = urlParam(req, "studentId");
 
         if (type.empty() || format.empty()) {
             return errorResponse("BadRequest", "type and format are required", 400);
         }
 
-        // 根据类型生成不同报表
-        json result;
+        // 根据类型生成不同报表：各部分直接取类型化的统计结果，不经过 HTTP 响应
+        json data;
 
         if (type == "overall") {
-            // 总体统计
-            auto students = dataManager->getStudents();
-            auto courses = dataManager->getCourses();
-            auto grades = dataManager->getGrades();
-
-            double avgScore = 0.0;
-            double passRate = 0.0;
-            int totalGrades = grades.size();
-
-            if (totalGrades > 0) {
-                int totalScore = 0;
-                int passCount = 0;
-                for (const auto& grade : grades) {
-                    totalScore += grade.score;
-                    if (grade.score >= 60) passCount++;
-                }
-                avgScore = static_cast<double>(totalScore) / totalGrades;
-                passRate = (static_cast<double>(passCount) / totalGrades) * 100.0;
+            // 总体统计，附平均分前 K 名
+            auto topK = parseTopK(req, 10);
+            if (!topK.has_value()) {
+                return errorResponse("BadRequest", "Invalid k", 400);
             }
-
-            result = {
-                {"type", "overall"},
-                {"format", format},
-                {"data", {
-                    {"avgScore", avgScore},
-                    {"passRate", passRate},
-                    {"totalStudents", static_cast<int>(students.size())},
-                    {"totalCourses", static_cast<int>(courses.size())},
-                    {"totalGrades", totalGrades}
-                }}
-            };
+            data = overviewStatistics();
+            data["topStudents"] = topStudents(topK.value());
         } else if (type == "class") {
             // 班级统计
             if (classFilter.empty()) {
                 return errorResponse("BadRequest", "class parameter is required for class report", 400);
             }
-            
-            // 调用班级统计方法
-            auto response = getClassStatistics(req);
-            result = {
-                {"type", "class"},
-                {"format", format},
-                {"data", json::parse(response.body)}
-            };
+            auto topK = parseTopK(req, 3);
+            if (!topK.has_value()) {
+                return errorResponse("BadRequest", "Invalid k", 400);
+            }
+            data = classStatistics(classFilter, topK.value());
         } else if (type == "course") {
             // 课程统计
             if (courseId.empty()) {
                 return errorResponse("BadRequest", "courseId parameter is required for course report", 400);
             }
-            
-            // 调用课程统计方法
-            auto response = getCourseStatistics(req);
-            result = {
-                {"type", "course"},
-                {"format", format},
-                {"data", json::parse(response.body)}
-            };
+            auto course = courseStatistics(courseId);
+            if (!course.has_value()) {
+                return errorResponse("NotFound", "Course not found", 404);
+            }
+            data = course.value();
         } else if (type == "student") {
             // 学生统计
             if (studentId.empty()) {
                 return errorResponse("BadRequest", "studentId parameter is required for student report", 400);
             }
-            
-            // 获取学生成绩概览
-            auto students = dataManager->getStudents();
-            auto studentIt = std::find_if(students.begin(), students.end(),
-                [&](const Student& s) { return s.studentId == studentId; });
-            
-            if (studentIt == students.end()) {
+            auto student = studentStatistics(studentId);
+            if (!student.has_value()) {
                 return errorResponse("NotFound", "Student not found", 404);
             }
-
-            auto grades = dataManager->getGrades();
-            std::vector<Grade> studentGrades;
-            for (const auto& grade : grades) {
-                if (grade.studentId == studentId) {
-                    studentGrades.push_back(grade);
-                }
-            }
-
-            int totalCourses = studentGrades.size();
-            double avgScore = 0.0;
-            int passCount = 0;
-            int totalScore = 0;
-
-            for (const auto& grade : studentGrades) {
-                totalScore += grade.score;
-                if (grade.score >= 60) passCount++;
-            }
-
-            if (totalCourses > 0) {
-                avgScore = static_cast<double>(totalScore) / totalCourses;
-            }
-
-            double passRate = totalCourses > 0 ? 
-                (static_cast<double>(passCount) / totalCourses) * 100.0 : 0.0;
-
-            result = {
-                {"type", "student"},
-                {"format", format},
-                {"data", {
-                    {"studentId", studentId},
-                    {"studentName", studentIt->name},
-                    {"className", studentIt->className},
-                    {"totalCourses", totalCourses},
-                    {"avgScore", avgScore},
-                    {"passRate", passRate},
-                    {"totalScore", totalScore}
-                }}
-            };
+            data = student.value();
         } else {
             return errorResponse("BadRequest", "Invalid type", 400);
         }
 
+        json result = {
+            {"type", type},
+            {"format", format},
+            {"data", data}
+        };
+
         // 记录日志
         auto currentUser = authManager->getCurrentUser(token.substr(7));
         if (currentUser.has_value()) {
@@ -659,6 +646,312 @@ public:
         // 这里返回JSON作为演示
         return jsonResponse(result);
     }
+
+    // ==================== 类型化统计计算（供接口与报表直接调用） ====================
+
+    // 统计概览：全部取自累计量，O(1)
+    OverviewStatistics overviewStatistics() const {
+        const auto& stats = dataManager->statistics();
+        ScoreStats overall = stats.overallStats();
+        return OverviewStatistics{
+            overall.average(),
+            overall.passRate(),
+            static_cast<int>(stats.totalStudents()),
+            static_cast<int>(stats.totalCourses()),
+            static_cast<int>(overall.count)
+        };
+    }
+
+    // 各班级（或指定班级）的平均分、及格率与按最高分排名的前 topK 名学生
+    std::vector<ClassStatistics> classStatistics(const std::string& classFilter, int topK) {
+        const auto& stats = dataManager->statistics();
+        auto students = dataManager->getStudents();
+
+        // 每个班级一个有界堆：学生以其最高分参与排名，同一学生只出现一次
+        std::unordered_map<std::string, const Student*> studentById;
+        std::unordered_map<std::string, TopK<std::string, int>> topByClass;
+        for (const auto& student : students) {
+            if (!classFilter.empty() && student.className != classFilter) continue;
+            studentById.emplace(student.studentId, &student);
+            auto highest = stats.studentHighest(student.studentId);
+            if (!highest.has_value()) continue;
+            topByClass.try_emplace(student.className, topK).first->second.offer(student.studentId, highest.value());
+        }
+
+        std::vector<ClassStatistics> result;
+        for (const auto& className : stats.classes()) {
+            if (!classFilter.empty() && className != classFilter) continue;
+
+            // 平均分与及格率取自班级累计量
+            auto classStats = stats.classStats(className);
+            if (!classStats.has_value()) continue;
+
+            ClassStatistics item{className, classStats->average(), classStats->passRate(),
+                                 static_cast<int>(stats.classStudentCount(className)), {}};
+            auto top = topByClass.find(className);
+            if (top != topByClass.end()) {
+                for (const auto& [studentId, score] : top->second.sorted()) {
+                    item.topStudents.push_back({studentId, studentById.at(studentId)->name, score});
+                }
+            }
+            result.push_back(std::move(item));
+        }
+        return result;
+    }
+
+    // 课程统计；课程不存在时返回 nullopt
+    std::optional<CourseStatistics> courseStatistics(const std::string& courseId) {
+        auto courses = dataManager->getCourses();
+        auto courseIt = std::find_if(courses.begin(), courses.end(),
+            [&](const Course& c) { return c.courseId == courseId; });
+        if (courseIt == courses.end()) return std::nullopt;
+
+        CourseStatistics result;
+        result.courseId = courseId;
+        result.courseName = courseIt->name;
+
+        // 读取课程累计量，不扫描成绩
+        const auto& stats = dataManager->statistics();
+        auto courseStats = stats.courseStats(courseId);
+        if (courseStats.has_value()) {
+            result.avgScore = courseStats->average();
+            result.passRate = courseStats->passRate();
+            result.totalStudents = static_cast<int>(stats.courseStudentCount(courseId));
+            result.highestScore = courseStats->highest();
+            result.lowestScore = courseStats->lowest();
+        }
+        return result;
+    }
+
+    // 学生成绩汇总；学生不存在时返回 nullopt
+    std::optional<StudentStatistics> studentStatistics(const std::string& studentId) {
+        auto students = dataManager->getStudents();
+        auto studentIt = std::find_if(students.begin(), students.end(),
+            [&](const Student& s) { return s.studentId == studentId; });
+        if (studentIt == students.end()) return std::nullopt;
+
+        ScoreStats studentStats = dataManager->statistics().studentStats(studentId).value_or(ScoreStats{});
+        return StudentStatistics{
+            studentId,
+            studentIt->name,
+            studentIt->className,
+            static_cast<int>(studentStats.count),
+            studentStats.average(),
+            studentStats.passRate(),
+            studentStats.sum
+        };
+    }
+
+    // 全体学生按平均分的前 K 名（由学生累计量得到，不扫描成绩）
+    std::vector<LeaderboardEntry> topStudents(int k) {
+        const auto& stats = dataManager->statistics();
+        auto students = dataManager->getStudents();
+        std::unordered_map<std::string, const Student*> studentById;
+        for (const auto& student : students) {
+            studentById.emplace(student.studentId, &student);
+        }
+
+        TopK<std::string, double> leaders(k);
+        stats.forEachStudent([&](const std::string& studentId, const ScoreStats& scores) {
+            if (studentById.count(studentId) > 0) leaders.offer(studentId, scores.average());
+        });
+
+        std::vector<LeaderboardEntry> result;
+        int rank = 0;
+        for (const auto& [studentId, avgScore] : leaders.sorted()) {
+            const Student* student = studentById.at(studentId);
+            result.push_back({++rank, studentId, student->name, student->className, avgScore});
+        }
+        return result;
+    }
+
+    // 各分数段的人数与占比（按 ranges 的顺序）
+    std::vector<BucketCount> distribution(const std::string& courseId, const std::string& classFilter,
+                                          const std::vector<ScoreRange>& ranges) {
+        ScoreStats histogram = scopeStats(courseId, classFilter);
+        int total = histogram.count;
+        std::vector<BucketCount> result;
+        for (const auto& range : ranges) {
+            int count = histogram.countBetween(range.min, range.max);
+            double percentage = total > 0 ? (static_cast<double>(count) / total) * 100.0 : 0.0;
+            result.push_back({range, count, percentage});
+        }
+        return result;
+    }
+
+    // 分位数统计：全部由直方图与累计矩得到，与成绩数量无关
+    PercentileStatistics percentiles(const std::string& courseId, const std::string& classFilter,
+                                     const std::vector<double>& points, std::optional<int> rankScore) {
+        ScoreStats stats = scopeStats(courseId, classFilter);
+        PercentileStatistics result;
+        result.courseId = courseId;
+        result.className = classFilter;
+        result.count = static_cast<int>(stats.count);
+        result.avgScore = stats.average();
+        result.median = stats.median();
+        result.q1 = stats.quantile(0.25);
+        result.q3 = stats.quantile(0.75);
+        result.stddev = stats.stddev();
+        result.highestScore = stats.highest();
+        result.lowestScore = stats.lowest();
+        for (double p : points) result.percentiles.emplace_back(p, stats.quantile(p / 100.0));
+        if (rankScore.has_value()) {
+            result.percentileRank = std::make_pair(rankScore.value(), stats.percentileRank(rankScore.value()));
+        }
+        return result;
+    }
+
+    // 多个范围的累计量：课程、学生名单各只读取一次，各范围直接取自累计量
+    std::vector<ScopeStatistics> scopeStatistics(const std::vector<StatisticsScope>& scopes) {
+        bool needCourses = false;
+        bool needStudents = false;
+        for (const auto& scope : scopes) {
+            needCourses = needCourses || scope.type == "course" || scope.type == "cell";
+            needStudents = needStudents || scope.type == "student";
+        }
+
+        std::vector<Course> courses;
+        std::vector<Student> students;
+        if (needCourses) courses = dataManager->getCourses();
+        if (needStudents) students = dataManager->getStudents();
+        std::unordered_map<std::string, const Course*> courseById;
+        for (const auto& course : courses) courseById.emplace(course.courseId, &course);
+        std::unordered_map<std::string, const Student*> studentById;
+        for (const auto& student : students) studentById.emplace(student.studentId, &student);
+
+        const auto& stats = dataManager->statistics();
+        std::vector<ScopeStatistics> result;
+        result.reserve(scopes.size());
+        for (const auto& scope : scopes) {
+            ScopeStatistics item;
+            item.scope = scope;
+            if (scope.type == "overall") {
+                item.found = true;
+                item.stats = stats.overallStats();
+            } else if (scope.type == "course") {
+                auto course = courseById.find(scope.id);
+                item.found = course != courseById.end();
+                if (item.found) item.name = course->second->name;
+                item.stats = stats.courseStats(scope.id).value_or(ScoreStats{});
+            } else if (scope.type == "class") {
+                item.found = stats.classStudentCount(scope.id) > 0;
+                item.stats = stats.classStats(scope.id).value_or(ScoreStats{});
+            } else if (scope.type == "student") {
+                auto student = studentById.find(scope.id);
+                item.found = student != studentById.end();
+                if (item.found) item.name = student->second->name;
+                item.stats = stats.studentStats(scope.id).value_or(ScoreStats{});
+            } else if (scope.type == "cell") {
+                auto course = courseById.find(scope.courseId);
+                item.found = course != courseById.end() && stats.classStudentCount(scope.className) > 0;
+                if (item.found) item.name = course->second->name;
+                item.stats = stats.cellStats(scope.className, scope.courseId).value_or(ScoreStats{});
+            }
+            result.push_back(std::move(item));
+        }
+        return result;
+    }
+
+private:
+    static constexpr size_t MAX_BATCH_SCOPES = 500;
+
+    // 解析批量统计的一个范围；类型未知或缺少标识时返回 nullopt
+    static std::optional<StatisticsScope> parseScope(const json& item) {
+        if (!item.is_object() || !item.contains("type") || !item["type"].is_string()) return std::nullopt;
+        auto text = [&](const char* key) -> std::string {
+            return item.contains(key) && item[key].is_string() ? item[key].get<std::string>() : "";
+        };
+        StatisticsScope scope;
+        scope.type = item["type"].get<std::string>();
+        if (scope.type == "overall") return scope;
+        if (scope.type == "course" || scope.type == "class" || scope.type == "student") {
+            scope.id = text("id");
+            if (scope.id.empty()) return std::nullopt;
+            return scope;
+        }
+        if (scope.type == "cell") {
+            scope.className = text("class");
+            scope.courseId = text("courseId");
+            if (scope.className.empty() || scope.courseId.empty()) return std::nullopt;
+            return scope;
+        }
+        return std::nullopt;
+    }
+
+    // 由累计量取一个指标；未知指标返回 nullopt
+    static std::optional<json> metricValue(const std::string& metric, const ScoreStats& stats) {
+        if (metric == "count") return json(static_cast<int>(stats.count));
+        if (metric == "totalScore") return json(stats.sum);
+        if (metric == "avgScore") return json(stats.average());
+        if (metric == "passRate") return json(stats.passRate());
+        if (metric == "passCount") return json(static_cast<int>(stats.passCount));
+        if (metric == "highestScore") return json(stats.highest());
+        if (metric == "lowestScore") return json(stats.lowest());
+        if (metric == "median") return json(stats.median());
+        if (metric == "q1") return json(stats.quantile(0.25));
+        if (metric == "q3") return json(stats.quantile(0.75));
+        if (metric == "stddev") return json(stats.stddev());
+        return std::nullopt;
+    }
+
+    // 命中缓存时直接返回序列化好的响应体；未命中时计算，只缓存成功的响应
+    // stamp 须在 compute 读取任何数据之前取得
+    template<typename Compute>
+    crow::response cached(const std::string& key, StatsCache::Stamp stamp, Compute compute) {
+        if (auto body = cache.get(key, stamp)) {
+            crow::response res(200);
+            res.set_header("Content-Type", "application/json");
+            res.body = std::move(body.value());
+            return res;
+        }
+        crow::response res = compute();
+        if (res.code == 200) cache.put(key, std::move(stamp), res.body);
+        return res;
+    }
+
+    // 范围的版本戳：按课程/班级筛选时取这些范围的版本号，不筛选时取成绩集合版本号
+    StatsCache::Stamp scopeStamp(const std::string& courseId, const std::string& classFilter) const {
+        const auto& stats = dataManager->statistics();
+        StatsCache::Stamp stamp;
+        if (!courseId.empty()) stamp.push_back(stats.courseVersion(courseId));
+        if (!classFilter.empty()) stamp.push_back(stats.classVersion(classFilter));
+        if (stamp.empty()) stamp.push_back(dataManager->versions().grades);
+        return stamp;
+    }
+
+    // 课程/班级/班级×课程/全部成绩的累计量
+    ScoreStats scopeStats(const std::string& courseId, const std::string& classFilter) {
+        const auto& stats = dataManager->statistics();
+        if (!courseId.empty() && !classFilter.empty()) return stats.cellStats(classFilter, courseId).value_or(ScoreStats{});
+        if (!courseId.empty()) return stats.courseStats(courseId).value_or(ScoreStats{});
+        if (!classFilter.empty()) return stats.classStats(classFilter).value_or(ScoreStats{});
+        return stats.overallStats();
+    }
+
+    // URL 参数，未提供时为空串
+    static std::string urlParam(const crow::request& req, const char* name) {
+        const char* value = req.url_params.get(name);
+        return value != nullptr ? value : "";
+    }
+
+    // Top-K 的 K：?k= 或 X-Query-TopK，1–100；格式错误返回 nullopt
+    static std::optional<int> parseTopK(const crow::request& req, int defaultK) {
+        std::string text;
+        if (req.url_params.get("k") != nullptr) {
+            text = req.url_params.get("k");
+        } else {
+            text = req.get_header_value("X-Query-TopK");
+        }
+        if (text.empty()) return defaultK;
+        try {
+            size_t used = 0;
+            int k = std::stoi(text, &used);
+            if (used != text.size() || k < 1 || k > 100) return std::nullopt;
+            return k;
+        } catch (...) {
+            return std::nullopt;
+        }
+    }
 };
 
 #endif // STATISTICS_SERVICE_H
\ No newline at end of file
@@ -0,0 +1,83 @@
+#ifndef STATS_CACHE_H
+#define STATS_CACHE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// 统计结果缓存：键为 (接口, 规整后的筛选参数)，值为序列化好的响应体
+// 每条结果附带计算前读取的版本戳（所依赖的集合/课程/班级版本号），读取时与当前版本戳不一致即失效
+// 版本戳必须在计算之前读取：计算期间发生写入时，缓存的结果带旧版本戳，下一次读取即失效
+// 容量有限，按最近使用淘汰
+class StatsCache {
+public:
+    using Stamp = std::vector<uint64_t>;
+
+private:
+    struct Entry {
+        Stamp stamp;
+        std::string body;
+        std::list<std::string>::iterator order;
+    };
+
+    mutable std::mutex mutex;
+    size_t capacity;
+    std::list<std::string> recent; // 最近使用的在前
+    std::unordered_map<std::string, Entry> entries;
+
+public:
+    explicit StatsCache(size_t maxEntries = 1024) : capacity(std::max<size_t>(maxEntries, 1)) {}
+
+    // 由接口名与参数拼接缓存键（参数需事先规整，如排序、去除默认值）
+    static std::string key(const std::string& endpoint, const std::vector<std::string>& params) {
+        std::string result = endpoint;
+        for (const auto& param : params) {
+            result += '\x1f';
+            result += param;
+        }
+        return result;
+    }
+
+    std::optional<std::string> get(const std::string& cacheKey, const Stamp& stamp) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(cacheKey);
+        if (it == entries.end()) return std::nullopt;
+        if (it->second.stamp != stamp) {
+            recent.erase(it->second.order);
+            entries.erase(it);
+            return std::nullopt;
+        }
+        recent.splice(recent.begin(), recent, it->second.order);
+        return it->second.body;
+    }
+
+    void put(const std::string& cacheKey, Stamp stamp, std::string body) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(cacheKey);
+        if (it != entries.end()) {
+            it->second.stamp = std::move(stamp);
+            it->second.body = std::move(body);
+            recent.splice(recent.begin(), recent, it->second.order);
+            return;
+        }
+        if (entries.size() >= capacity) {
+            entries.erase(recent.back());
+            recent.pop_back();
+        }
+        recent.push_front(cacheKey);
+        entries.emplace(cacheKey, Entry{std::move(stamp), std::move(body), recent.begin()});
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+};
+
+#endif // STATS_CACHE_H
@@ -136,7 +136,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin", "teacher"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::STAFF)) {
             return errorResponse("Forbidden", "Admin or teacher only", 403);
         }
 
@@ -218,7 +218,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin", "teacher"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::STAFF)) {
             return errorResponse("Forbidden", "Admin or teacher only", 403);
         }
 
@@ -284,7 +284,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
             return errorResponse("Forbidden", "Admin only", 403);
         }
 
@@ -330,45 +330,16 @@ public:
             return errorResponse("NotFound", "Student not found", 404);
         }
 
-        // 获取成绩
-        auto grades = dataManager->getGrades();
-        std::vector<Grade> studentGrades;
-        for (const auto& grade : grades) {
-            if (grade.studentId == studentId) {
-                studentGrades.push_back(grade);
-            }
-        }
-
-        // 计算统计信息
-        int totalCourses = studentGrades.size();
-        double avgScore = 0.0;
-        int passCount = 0;
-        int totalScore = 0;
-
-        for (const auto& grade : studentGrades) {
-            totalScore += grade.score;
-            if (grade.score >= 60) passCount++;
-        }
-
-        if (totalCourses > 0) {
-            avgScore = static_cast<double>(totalScore) / totalCourses;
-        }
-
-        double passRate = totalCourses > 0 ? 
-            (static_cast<double>(passCount) / totalCourses) * 100.0 : 0.0;
-
-        // 最近成绩（最多5条）
-        std::vector<Grade> recentGrades;
-        int count = 0;
-        for (auto it = studentGrades.rbegin(); it != studentGrades.rend() && count < 5; ++it, ++count) {
-            recentGrades.push_back(*it);
-        }
+        // 统计信息与最近成绩（最多5条）取自学生累计量，不扫描成绩文件
+        const auto& stats = dataManager->statistics();
+        ScoreStats studentStats = stats.studentStats(studentId).value_or(ScoreStats{});
+        auto recentGrades = stats.recentGrades(studentId, 5);
 
         json result = {
-            {"totalCourses", totalCourses},
-            {"avgScore", avgScore},
-            {"passRate", passRate},
-            {"totalScore", totalScore},
+            {"totalCourses", static_cast<int>(studentStats.count)},
+            {"avgScore", studentStats.average()},
+            {"passRate", studentStats.passRate()},
+            {"totalScore", studentStats.sum},
             {"recentGrades", json::array()}
         };
 
@@ -397,7 +368,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
             return errorResponse("Forbidden", "Admin only", 403);
         }
 
@@ -11,16 +11,19 @@
 #include "data_manager.h"
 #include "auth.h"
 #include "middleware.h"
+#include "log_export.h"
+#include "retention_task.h"
 
 class SystemService {
 private:
     DataManager* dataManager;
     AuthManager* authManager;
     LogMiddleware* logger;
+    RetentionTask* retention;
 
 public:
-    SystemService(DataManager* dm, AuthManager* am, LogMiddleware* log) 
-        : dataManager(dm), authManager(am), logger(log) {}
+    SystemService(DataManager* dm, AuthManager* am, LogMiddleware* log, RetentionTask* rt) 
+        : dataManager(dm), authManager(am), logger(log), retention(rt) {}
 
     // 创建备份
     crow::response createBackup(const crow::request& req) {
@@ -30,7 +33,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
             return errorResponse("Forbidden", "Admin only", 403);
         }
 
@@ -77,7 +80,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
             return errorResponse("Forbidden", "Admin only", 403);
         }
 
@@ -101,7 +104,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
             return errorResponse("Forbidden", "Admin only", 403);
         }
 
@@ -125,6 +128,7 @@ public:
         if (!success) {
             return errorResponse("InternalError", "Restore failed", 500);
         }
+        logger->reloadPolicies(); // 备份中的设置可能包含不同的日志策略
 
         // 记录日志
         auto currentUser = authManager->getCurrentUser(token.substr(7));
@@ -144,7 +148,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
             return errorResponse("Forbidden", "Admin only", 403);
         }
 
@@ -173,7 +177,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
             return errorResponse("Forbidden", "Admin only", 403);
         }
 
@@ -181,48 +185,74 @@ public:
         auto [page, limit] = parsePaginationParams(req, 1, 10, 1000);
         
         // 获取过滤参数
-        std::string level = req.get_header_value("X-Query-Level");
-        std::string startTime = req.get_header_value("X-Query-StartTime");
-        std::string endTime = req.get_header_value("X-Query-EndTime");
+        LogQuery query;
+        query.level = req.get_header_value("X-Query-Level");
+        query.module = req.get_header_value("X-Query-Module");
+        // 全文检索：?q= 或 X-Query-Text，消息须包含全部词
+        if (req.url_params.get("q") != nullptr) {
+            query.text = req.url_params.get("q");
+        } else {
+            query.text = req.get_header_value("X-Query-Text");
+        }
+        query.range = LogTimeRange::parse(req.get_header_value("X-Query-StartTime"),
+                                          req.get_header_value("X-Query-EndTime"));
+        if (!query.range.has_value()) {
+            return errorResponse("BadRequest", "Invalid time range", 400);
+        }
+        query.skip = static_cast<size_t>(page - 1) * limit;
+        query.limit = limit;
+        query.newestFirst = false; // 与原接口一致：从旧到新分页
         
         // 解析字段选择参数
-        bool fullData = requestFullData(req);
         std::vector<std::string> fields = parseFieldsParam(req);
 
-        auto logs = dataManager->getSystemLogs();
+        // 通过检索索引求交得到本页日志，不扫描全部日志
+        auto logPage = dataManager->querySystemLogs(query);
+        json result = logPageJson(logPage, page, limit, fields);
         
-        // 筛选（先过滤再分页）
-        std::vector<SystemLog> filtered;
-        for (const auto& log : logs) {
-            if (!level.empty() && log.level != level) continue;
-            // 时间筛选简化处理
-            filtered.push_back(log);
+        // 记录日志（包含分页参数）
+        auto currentUser = authManager->getCurrentUser(token.substr(7));
+        if (currentUser.has_value()) {
+            logger->logOperation(currentUser.value().id, currentUser.value().username,
+                               "GET /system/logs", "系统管理");
         }
 
-        // 分页（使用ISO日期格式）
-        auto result = paginateWithISO(filtered, page, limit, 
-            [this](const std::string& ts) { return dataManager->convertToISO8601(ts); });
-        
-        // 如果指定了fields，进行字段过滤
-        if (!fields.empty() && result.contains("data")) {
-            json filteredData = json::array();
-            for (auto& item : result["data"]) {
-                json filteredItem;
-                for (const auto& field : fields) {
-                    if (item.contains(field)) {
-                        filteredItem[field] = item[field];
-                    }
-                }
-                filteredData.push_back(filteredItem);
-            }
-            result["data"] = filteredData;
+        return jsonResponse(result);
+    }
+
+    // 检索操作日志（管理员）：按用户、模块与时间范围过滤
+    crow::response getOperationLogs(const crow::request& req) {
+        auto token = req.get_header_value("Authorization");
+        if (token.empty() || token.substr(0, 7) != "Bearer ") {
+            return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        // 记录日志（包含分页参数）
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
+            return errorResponse("Forbidden", "Admin only", 403);
+        }
+
+        auto [page, limit] = parsePaginationParams(req, 1, 10, 1000);
+
+        LogQuery query;
+        query.userId = req.get_header_value("X-Query-UserId");
+        query.module = req.get_header_value("X-Query-Module");
+        query.range = LogTimeRange::parse(req.get_header_value("X-Query-StartTime"),
+                                          req.get_header_value("X-Query-EndTime"));
+        if (!query.range.has_value()) {
+            return errorResponse("BadRequest", "Invalid time range", 400);
+        }
+        query.skip = static_cast<size_t>(page - 1) * limit;
+        query.limit = limit;
+
+        std::vector<std::string> fields = parseFieldsParam(req);
+
+        auto logPage = dataManager->queryOperationLogs(query);
+        json result = logPageJson(logPage, page, limit, fields);
+
         auto currentUser = authManager->getCurrentUser(token.substr(7));
         if (currentUser.has_value()) {
             logger->logOperation(currentUser.value().id, currentUser.value().username,
-                               "GET /system/logs", "系统管理");
+                               "GET /system/operation-logs", "系统管理");
         }
 
         return jsonResponse(result);
@@ -236,7 +266,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
             return errorResponse("Forbidden", "Admin only", 403);
         }
 
@@ -260,7 +290,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
             return errorResponse("Forbidden", "Admin only", 403);
         }
 
@@ -282,10 +312,31 @@ public:
             body["backupInterval"],
             body["logRetentionDays"],
             body["maxLoginAttempts"],
-            body["sessionTimeout"]
+            body["sessionTimeout"],
+            {}
         };
 
+        // 日志策略可选，未提供时保留原有策略
+        if (body.contains("logPolicies")) {
+            try {
+                settings.logPolicies = body["logPolicies"].get<std::vector<LogPolicy>>();
+            } catch (...) {
+                return errorResponse("BadRequest", "logPolicies must be an array", 400);
+            }
+            for (const auto& policy : settings.logPolicies) {
+                if (!LogPolicy::isValidMode(policy.mode)) {
+                    return errorResponse("BadRequest", "Invalid log policy mode: " + policy.mode, 400);
+                }
+                if (policy.sampleRate < 1) {
+                    return errorResponse("BadRequest", "sampleRate must be >= 1", 400);
+                }
+            }
+        } else {
+            settings.logPolicies = dataManager->getSettings().logPolicies;
+        }
+
         dataManager->saveSettings(settings);
+        logger->reloadPolicies(); // 热更新日志策略
 
         // 记录日志
         auto currentUser = authManager->getCurrentUser(token.substr(7));
@@ -297,7 +348,7 @@ public:
         return jsonResponse(std::string("Settings updated successfully"));
     }
 
-    // 清理日志
+    // 清理日志：唤醒后台保留任务立即执行，不在请求线程中删除文件
     crow::response cleanLogs(const crow::request& req) {
         // 验证权限（管理员）
         auto token = req.get_header_value("Authorization");
@@ -305,13 +356,11 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
             return errorResponse("Forbidden", "Admin only", 403);
         }
 
-        // 获取设置中的保留天数
-        auto settings = dataManager->getSettings();
-        dataManager->cleanLogs(settings.logRetentionDays);
+        retention->runNow();
 
         // 记录日志
         auto currentUser = authManager->getCurrentUser(token.substr(7));
@@ -320,10 +369,30 @@ public:
                                "POST /system/clean-logs", "系统管理");
         }
 
-        return jsonResponse(std::string("Logs cleaned successfully"));
+        json result = retention->status();
+        result["message"] = "Log cleanup scheduled";
+        return jsonResponse(result, 202);
     }
 
-    // 导出日志（简化处理，返回CSV格式的JSON）
+    // 获取日志保留任务状态
+    crow::response getRetentionStatus(const crow::request& req) {
+        // 验证权限（管理员）
+        auto token = req.get_header_value("Authorization");
+        if (token.empty() || token.substr(0, 7) != "Bearer ") {
+            return errorResponse("Unauthorized", "Missing token", 401);
+        }
+        
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
+            return errorResponse("Forbidden", "Admin only", 403);
+        }
+
+        json result = retention->status();
+        result["retentionDays"] = dataManager->getSettings().logRetentionDays;
+        return jsonResponse(result);
+    }
+
+    // 导出日志：从日志段逐条读取、过滤后写入导出文件，再由 Crow 按块发送文件
+    // 内存占用与导出条数无关；支持 NDJSON / CSV 两种格式
     crow::response exportLogs(const crow::request& req) {
         // 验证权限（管理员）
         auto token = req.get_header_value("Authorization");
@@ -331,37 +400,67 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
             return errorResponse("Forbidden", "Admin only", 403);
         }
 
         // 获取查询参数
+        std::string type = req.get_header_value("X-Query-Type");
+        std::string format = req.get_header_value("X-Query-Format");
         std::string level = req.get_header_value("X-Query-Level");
         std::string startTime = req.get_header_value("X-Query-StartTime");
         std::string endTime = req.get_header_value("X-Query-EndTime");
-
-        auto logs = dataManager->getSystemLogs();
-        
-        // 筛选
-        std::vector<SystemLog> filtered;
-        for (const auto& log : logs) {
-            if (!level.empty() && log.level != level) continue;
-            // 时间筛选简化处理
-            filtered.push_back(log);
-        }
-
-        // 生成CSV内容（简化处理，返回JSON格式）
-        json result = json::array();
-        for (const auto& log : filtered) {
-            result.push_back({
-                {"id", log.id},
-                {"level", log.level},
-                {"message", log.message},
-                {"module", log.module},
-                {"ip", log.ip.value_or("")},
-                {"createdAt", dataManager->convertToISO8601(log.createdAt)}
+        if (type.empty()) type = "system";
+        if (format.empty()) format = "ndjson";
+
+        if (type != "system" && type != "operation" && type != "access") {
+            return errorResponse("BadRequest", "Type must be system, operation or access", 400);
+        }
+        if (format != "ndjson" && format != "csv") {
+            return errorResponse("BadRequest", "Format must be ndjson or csv", 400);
+        }
+        auto range = LogTimeRange::parse(startTime, endTime);
+        if (!range.has_value()) {
+            return errorResponse("BadRequest", "Invalid time range", 400);
+        }
+
+        removeStaleExports();
+        std::string fileName = type + "_logs_" + dataManager->generateId() + "." + format;
+        std::string path = dataManager->getExportDir() + "/" + fileName;
+        std::ofstream out(path, std::ios::binary);
+        if (!out.is_open()) {
+            return errorResponse("InternalError", "Cannot create export file", 500);
+        }
+
+        size_t count = 0;
+        bool csv = format == "csv";
+        auto write = [&](const auto& log) {
+            if (!range->contains(log.createdAt)) return;
+            if (count == 0 && csv) LogExport::writeCsvHeader(out, log);
+            std::string createdAt = dataManager->convertToISO8601(log.createdAt);
+            if (csv) {
+                LogExport::writeCsv(out, log, createdAt);
+            } else {
+                LogExport::writeNdjson(out, log, createdAt);
+            }
+            count++;
+        };
+        if (type == "system") {
+            dataManager->systemLogs().forEachInDays(range->fromDay(), range->toDay(), [&](const SystemLog& log) {
+                if (!level.empty() && log.level != level) return;
+                write(log);
             });
+        } else if (type == "operation") {
+            dataManager->operationLogs().forEachInDays(range->fromDay(), range->toDay(), write);
+        } else {
+            dataManager->accessLogs().forEachInDays(range->fromDay(), range->toDay(), write);
+        }
+        if (count == 0 && csv) {
+            if (type == "system") LogExport::writeCsvHeader(out, SystemLog{});
+            else if (type == "operation") LogExport::writeCsvHeader(out, OperationLog{});
+            else LogExport::writeCsvHeader(out, AccessLog{});
         }
+        out.close();
 
         // 记录日志
         auto currentUser = authManager->getCurrentUser(token.substr(7));
@@ -370,8 +469,53 @@ public:
                                "GET /system/export-logs", "系统管理");
         }
 
-        // 返回JSON（实际应该返回CSV文件）
-        return jsonResponse(result);
+        crow::response res;
+        res.set_static_file_info_unsafe(path);
+        res.set_header("Content-Type", csv ? "text/csv; charset=utf-8" : "application/x-ndjson");
+        res.set_header("Content-Disposition", "attachment; filename=\"" + fileName + "\"");
+        res.set_header("X-Export-Count", std::to_string(count));
+        return res;
+    }
+
+private:
+    // 检索结果转为分页响应（日期转ISO 8601，指定 fields 时只保留这些字段）
+    template<typename T>
+    json logPageJson(const LogQueryPage<T>& logPage, int page, int limit, const std::vector<std::string>& fields) {
+        StageScope stage(RequestStage::SERIALIZE);
+        json data = json::array();
+        for (const auto& log : logPage.logs) {
+            json item;
+            to_json_iso(item, log, [this](const std::string& ts) { return dataManager->convertToISO8601(ts); });
+            if (!fields.empty()) {
+                json filteredItem;
+                for (const auto& field : fields) {
+                    if (item.contains(field)) {
+                        filteredItem[field] = item[field];
+                    }
+                }
+                item = filteredItem;
+            }
+            data.push_back(item);
+        }
+        int total = static_cast<int>(logPage.total);
+        return json{
+            {"data", data},
+            {"total", total},
+            {"page", page},
+            {"limit", limit},
+            {"totalPages", (total + limit - 1) / limit}
+        };
+    }
+
+    // 删除超过一小时的导出文件（发送完成后的残留）
+    void removeStaleExports() {
+        auto cutoff = fs::file_time_type::clock::now() - std::chrono::hours(1);
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator(dataManager->getExportDir(), ec)) {
+            if (entry.is_regular_file() && entry.last_write_time() < cutoff) {
+                fs::remove(entry.path(), ec);
+            }
+        }
     }
 };
 
@@ -0,0 +1,108 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+// 固定线程数 + 有界任务队列的线程池
+// - submit(): 队列满时阻塞等待（背压）
+// - trySubmit(): 队列满时立即返回 std::nullopt（快速失败）
+// capacity == 0 表示队列不设上限
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    size_t capacity;
+    bool stopping = false;
+
+    void workerLoop() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                notEmpty.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (stopping && tasks.empty()) return;
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            notFull.notify_one();
+            task();
+        }
+    }
+
+    bool isFull() const {
+        return capacity > 0 && tasks.size() >= capacity;
+    }
+
+    template<typename F>
+    static auto makeTask(F&& f) {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+        return std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+    }
+
+public:
+    explicit ThreadPool(size_t threadCount, size_t queueCapacity = 0) : capacity(queueCapacity) {
+        if (threadCount == 0) threadCount = 1;
+        for (size_t i = 0; i < threadCount; ++i) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        notEmpty.notify_all();
+        notFull.notify_all();
+        for (auto& worker : workers) {
+            if (worker.joinable()) worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    // 提交任务，队列满时阻塞
+    template<typename F>
+    auto submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        auto task = makeTask(std::forward<F>(f));
+        auto future = task->get_future();
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            notFull.wait(lock, [this] { return stopping || !isFull(); });
+            tasks.emplace([task] { (*task)(); });
+        }
+        notEmpty.notify_one();
+        return future;
+    }
+
+    // 尝试提交任务，队列满时返回 std::nullopt
+    template<typename F>
+    auto trySubmit(F&& f) -> std::optional<std::future<std::invoke_result_t<std::decay_t<F>>>> {
+        auto task = makeTask(std::forward<F>(f));
+        auto future = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping || isFull()) return std::nullopt;
+            tasks.emplace([task] { (*task)(); });
+        }
+        notEmpty.notify_one();
+        return future;
+    }
+};
+
+#endif // THREAD_POOL_H
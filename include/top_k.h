@@ -0,0 +1,77 @@
+#ifndef TOP_K_H
+#define TOP_K_H
+
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// 有界堆 Top-K：流式接收 (键, 分值)，只保留分值最高的 K 个不同的键，每个键取其最高分值
+// 堆顶为当前第 K 名，比它低的直接丢弃；已在堆中的键用哈希表定位，O(n log K)
+// 分值相同时键较小者排前，结果与输入顺序无关
+template<typename Key, typename Score, typename Hash = std::hash<Key>>
+class TopK {
+public:
+    using Entry = std::pair<Key, Score>;
+
+private:
+    size_t k;
+    std::vector<Entry> heap;                       // 小顶堆：堆顶为排名最低者
+    std::unordered_map<Key, Score, Hash> members;  // 堆中的键及其分值
+
+    // a 排在 b 之前（名次更高）
+    static bool ranksBefore(const Entry& a, const Entry& b) {
+        if (a.second != b.second) return a.second > b.second;
+        return a.first < b.first;
+    }
+
+    static bool heapLess(const Entry& a, const Entry& b) { return ranksBefore(a, b); }
+
+public:
+    explicit TopK(size_t limit) : k(limit) {
+        heap.reserve(limit);
+    }
+
+    void offer(const Key& key, Score score) {
+        if (k == 0) return;
+        auto member = members.find(key);
+        if (member != members.end()) {
+            if (!(score > member->second)) return;
+            // 提高已在堆中的键的分值：K 通常很小，就地修改后重建堆
+            member->second = score;
+            for (auto& entry : heap) {
+                if (entry.first == key) {
+                    entry.second = score;
+                    break;
+                }
+            }
+            std::make_heap(heap.begin(), heap.end(), heapLess);
+            return;
+        }
+        Entry entry{key, score};
+        if (heap.size() < k) {
+            members.emplace(key, score);
+            heap.push_back(std::move(entry));
+            std::push_heap(heap.begin(), heap.end(), heapLess);
+            return;
+        }
+        if (!ranksBefore(entry, heap.front())) return;
+        std::pop_heap(heap.begin(), heap.end(), heapLess);
+        members.erase(heap.back().first);
+        members.emplace(key, score);
+        heap.back() = std::move(entry);
+        std::push_heap(heap.begin(), heap.end(), heapLess);
+    }
+
+    size_t size() const { return heap.size(); }
+
+    // 按名次从高到低返回
+    std::vector<Entry> sorted() const {
+        std::vector<Entry> result(heap);
+        std::sort(result.begin(), result.end(), ranksBefore);
+        return result;
+    }
+};
+
+#endif // TOP_K_H
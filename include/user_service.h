@@ -4,6 +4,9 @@
 #include <string>
 #include <vector>
 #include <optional>
+#include <unordered_set>
+#include <unordered_map>
+#include <algorithm>
 #include <crow.h>
 #include "models.h"
 #include "data_manager.h"
@@ -28,7 +31,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
             return errorResponse("Forbidden", "Admin only", 403);
         }
 
@@ -76,7 +79,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
             return errorResponse("Forbidden", "Admin only", 403);
         }
 
@@ -135,7 +138,7 @@ public:
         User newUser{
             dataManager->generateId(),
             username,
-            authManager->sha256(password), // 存储密码哈希
+            authManager->hashPassword(password), // 存储密码哈希
             role,
             name,
             className,
@@ -164,7 +167,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
             return errorResponse("Forbidden", "Admin only", 403);
         }
 
@@ -203,7 +206,7 @@ public:
             if (!validatePassword(newPassword)) {
                 return errorResponse("BadRequest", "Password must be at least 6 characters", 400);
             }
-            it->passwordHash = authManager->sha256(newPassword);
+            it->passwordHash = authManager->hashPassword(newPassword);
         }
         // 更新 studentId（仅适用于学生账号）
         if (body.contains("studentId")) {
@@ -225,6 +228,9 @@ public:
         it->updatedAt = dataManager->getCurrentTimestamp();
         dataManager->saveUsers(users);
 
+        // 角色可能已变更，同步该用户会话中的角色掩码
+        authManager->updateUserRole(id, it->role);
+
         // 记录日志
         auto currentUser = authManager->getCurrentUser(token.substr(7));
         if (currentUser.has_value()) {
@@ -243,7 +249,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
             return errorResponse("Forbidden", "Admin only", 403);
         }
 
@@ -264,6 +270,9 @@ public:
         users.erase(it);
         dataManager->saveUsers(users);
 
+        // 吊销该用户的全部会话
+        authManager->revokeUserSessions(id);
+
         // 记录日志
         if (currentUser.has_value()) {
             logger->logOperation(currentUser.value().id, currentUser.value().username,
@@ -281,7 +290,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
             return errorResponse("Forbidden", "Admin only", 403);
         }
 
@@ -307,31 +316,37 @@ public:
         json successItems = json::array();
         json failedItems = json::array();
 
+        // 分三步：逐行校验 -> 并行计算密码哈希 -> 一次原子写入
+        // 每行的失败原因记录在 rowErrors 中，最后按原始顺序输出，与逐行处理时的结果一致
+        std::vector<std::optional<std::string>> rowErrors(usersArray.size());
+        std::vector<size_t> pendingRows;
+        std::vector<User> pendingUsers;
+        std::vector<std::string> pendingPasswords;
+
+        std::unordered_set<std::string> usernames;
+        for (const auto& u : existingUsers) usernames.insert(u.username);
+
+        std::optional<std::unordered_set<std::string>> studentIds;
+
         for (size_t i = 0; i < usersArray.size(); ++i) {
             const auto& userData = usersArray[i];
-            json errorDetails = json::object();
-            errorDetails["index"] = i;
             
             try {
                 // 验证必填字段
                 if (!userData.contains("username") || userData["username"].is_null()) {
-                    errorDetails["error"] = "Missing required field: username";
-                    failedItems.push_back(errorDetails);
+                    rowErrors[i] = "Missing required field: username";
                     continue;
                 }
                 if (!userData.contains("password") || userData["password"].is_null()) {
-                    errorDetails["error"] = "Missing required field: password";
-                    failedItems.push_back(errorDetails);
+                    rowErrors[i] = "Missing required field: password";
                     continue;
                 }
                 if (!userData.contains("role") || userData["role"].is_null()) {
-                    errorDetails["error"] = "Missing required field: role";
-                    failedItems.push_back(errorDetails);
+                    rowErrors[i] = "Missing required field: role";
                     continue;
                 }
                 if (!userData.contains("name") || userData["name"].is_null()) {
-                    errorDetails["error"] = "Missing required field: name";
-                    failedItems.push_back(errorDetails);
+                    rowErrors[i] = "Missing required field: name";
                     continue;
                 }
 
@@ -342,24 +357,19 @@ public:
                 
                 // 验证角色
                 if (role != "admin" && role != "teacher" && role != "student") {
-                    errorDetails["error"] = "Invalid role: " + role;
-                    failedItems.push_back(errorDetails);
+                    rowErrors[i] = "Invalid role: " + role;
                     continue;
                 }
 
                 // 验证密码长度
                 if (password.length() < 6) {
-                    errorDetails["error"] = "Password must be at least 6 characters";
-                    failedItems.push_back(errorDetails);
+                    rowErrors[i] = "Password must be at least 6 characters";
                     continue;
                 }
 
-                // 检查重复
-                auto it = std::find_if(existingUsers.begin(), existingUsers.end(),
-                    [&](const User& u) { return u.username == username; });
-                if (it != existingUsers.end()) {
-                    errorDetails["error"] = "Username already exists: " + username;
-                    failedItems.push_back(errorDetails);
+                // 检查重复（包括本批次中已通过校验的用户名）
+                if (usernames.count(username)) {
+                    rowErrors[i] = "Username already exists: " + username;
                     continue;
                 }
 
@@ -368,22 +378,22 @@ public:
                     batchStudentId = userData["studentId"];
                     // 如果是学生，验证学生记录存在
                     if (role == "student") {
-                        auto students = dataManager->getStudents();
-                        auto sIt = std::find_if(students.begin(), students.end(),
-                            [&](const Student& s) { return s.studentId == batchStudentId.value(); });
-                        if (sIt == students.end()) {
-                            errorDetails["error"] = "Student record not found for studentId: " + batchStudentId.value();
-                            failedItems.push_back(errorDetails);
+                        if (!studentIds.has_value()) {
+                            studentIds.emplace();
+                            for (const auto& s : dataManager->getStudents()) studentIds->insert(s.studentId);
+                        }
+                        if (!studentIds->count(batchStudentId.value())) {
+                            rowErrors[i] = "Student record not found for studentId: " + batchStudentId.value();
                             continue;
                         }
                     }
                 }
 
-                // 创建用户
+                // 暂存待创建用户，密码哈希稍后并行计算
                 User newUser{
                     dataManager->generateId(),
                     username,
-                    authManager->sha256(password), // 存储密码哈希
+                    "",
                     role,
                     name,
                     userData.contains("class") && !userData["class"].is_null() ? 
@@ -392,27 +402,59 @@ public:
                     dataManager->getCurrentTimestamp(),
                     dataManager->getCurrentTimestamp()
                 };
-                existingUsers.push_back(newUser);
-                
-                // 记录成功项
-                json successItem = json::object();
-                successItem["index"] = i;
-                successItem["username"] = username;
-                successItem["role"] = role;
-                successItems.push_back(successItem);
+                usernames.insert(username);
+                pendingRows.push_back(i);
+                pendingUsers.push_back(std::move(newUser));
+                pendingPasswords.push_back(std::move(password));
                 
             } catch (const std::exception& e) {
-                errorDetails["error"] = "Unexpected error: " + std::string(e.what());
-                failedItems.push_back(errorDetails);
+                rowErrors[i] = "Unexpected error: " + std::string(e.what());
             } catch (...) {
-                errorDetails["error"] = "Unknown error occurred";
-                failedItems.push_back(errorDetails);
+                rowErrors[i] = "Unknown error occurred";
             }
         }
 
-        // 保存数据
-        if (successItems.size() > 0) {
-            dataManager->saveUsers(existingUsers);
+        // 在密码哈希线程池中并行计算所有哈希
+        std::vector<std::string> hashErrors;
+        auto hashes = authManager->hashPasswords(pendingPasswords, &hashErrors);
+
+        // 一次原子写入所有有效用户（写入前基于最新数据再次检查用户名冲突）
+        if (!pendingRows.empty()) {
+            dataManager->updateUsers([&](std::vector<User>& users) {
+                std::unordered_set<std::string> current;
+                for (const auto& u : users) current.insert(u.username);
+                for (size_t k = 0; k < pendingRows.size(); ++k) {
+                    size_t i = pendingRows[k];
+                    if (!hashErrors[k].empty()) {
+                        rowErrors[i] = "Unexpected error: " + hashErrors[k];
+                        continue;
+                    }
+                    if (!current.insert(pendingUsers[k].username).second) {
+                        rowErrors[i] = "Username already exists: " + pendingUsers[k].username;
+                        continue;
+                    }
+                    pendingUsers[k].passwordHash = std::move(hashes[k]);
+                    users.push_back(pendingUsers[k]);
+                }
+            });
+        }
+
+        // 按原始顺序汇总结果
+        size_t next = 0;
+        for (size_t i = 0; i < usersArray.size(); ++i) {
+            if (rowErrors[i].has_value()) {
+                failedItems.push_back({{"index", i}, {"error", rowErrors[i].value()}});
+                if (next < pendingRows.size() && pendingRows[next] == i) next++;
+                continue;
+            }
+            if (next < pendingRows.size() && pendingRows[next] == i) {
+                const auto& user = pendingUsers[next++];
+                json successItem = json::object();
+                successItem["index"] = i;
+                successItem["username"] = user.username;
+                successItem["role"] = user.role;
+                successItems.push_back(successItem);
+            }
         }
 
         // 记录日志
@@ -450,7 +492,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
             return errorResponse("Forbidden", "Admin only", 403);
         }
 
@@ -472,6 +514,7 @@ public:
 
         int success = 0;
         int failed = 0;
+        std::vector<std::string> deletedIds;
 
         for (const auto& id : body["ids"]) {
             std::string userId = id;
@@ -487,6 +530,7 @@ public:
             
             if (it != users.end()) {
                 users.erase(it);
+                deletedIds.push_back(userId);
                 success++;
             } else {
                 failed++;
@@ -495,6 +539,9 @@ public:
 
         dataManager->saveUsers(users);
 
+        // 吊销被删除用户的全部会话
+        authManager->revokeUserSessions(deletedIds);
+
         // 记录日志
         if (currentUser.has_value()) {
             logger->logOperation(currentUser.value().id, currentUser.value().username,
@@ -516,7 +563,7 @@ public:
             return errorResponse("Unauthorized", "Missing token", 401);
         }
         
-        if (!authManager->hasPermission(token.substr(7), {"admin"})) {
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
             return errorResponse("Forbidden", "Admin only", 403);
         }
 
@@ -546,10 +593,13 @@ public:
         }
 
         // 更新密码哈希
-        it->passwordHash = authManager->sha256(newPassword);
+        it->passwordHash = authManager->hashPassword(newPassword);
         it->updatedAt = dataManager->getCurrentTimestamp();
         dataManager->saveUsers(users);
 
+        // 重置密码后，该用户已登录的会话全部失效
+        authManager->revokeUserSessions(id);
+
         // 记录日志
         auto currentUser = authManager->getCurrentUser(token.substr(7));
         if (currentUser.has_value()) {
@@ -560,6 +610,99 @@ public:
         return jsonResponse(std::string("Password reset successfully"));
     }
 
+    // 获取活跃会话列表（管理员）
+    crow::response getSessions(const crow::request& req) {
+        // 验证权限
+        auto token = req.get_header_value("Authorization");
+        if (token.empty() || token.substr(0, 7) != "Bearer ") {
+            return errorResponse("Unauthorized", "Missing token", 401);
+        }
+        
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
+            return errorResponse("Forbidden", "Admin only", 403);
+        }
+
+        // 解析分页参数（支持字符串和整数）
+        auto [page, limit] = parsePaginationParams(req, 1, 10, 1000);
+        
+        // 获取过滤参数
+        std::string userId = req.get_header_value("X-Query-UserId");
+
+        auto sessions = authManager->getActiveSessions(userId);
+        std::sort(sessions.begin(), sessions.end(),
+            [](const JWTToken& a, const JWTToken& b) {
+                return SessionStore::parseTime(a.issuedAt) > SessionStore::parseTime(b.issuedAt);
+            });
+
+        // 补充用户名
+        std::unordered_map<std::string, std::string> usernames;
+        for (const auto& user : dataManager->getUsers()) {
+            usernames[user.id] = user.username;
+        }
+
+        // 分页（不返回完整token，只返回前缀用于识别）
+        int total = sessions.size();
+        int start = (page - 1) * limit;
+        int end = std::min(start + limit, total);
+        json data = json::array();
+        for (int i = start; i < end; i++) {
+            const auto& session = sessions[i];
+            auto nameIt = usernames.find(session.userId);
+            data.push_back({
+                {"tokenPrefix", session.token.substr(0, 8)},
+                {"userId", session.userId},
+                {"username", nameIt != usernames.end() ? nameIt->second : ""},
+                {"issuedAt", SessionStore::toISO8601(session.issuedAt)},
+                {"expiresAt", SessionStore::toISO8601(session.expiresAt)}
+            });
+        }
+
+        json result = {
+            {"data", data},
+            {"total", total},
+            {"page", page},
+            {"limit", limit},
+            {"totalPages", (total + limit - 1) / limit}
+        };
+
+        // 记录日志
+        auto currentUser = authManager->getCurrentUser(token.substr(7));
+        if (currentUser.has_value()) {
+            logger->logOperation(currentUser.value().id, currentUser.value().username,
+                               "GET /users/sessions", "用户管理");
+        }
+
+        return jsonResponse(result);
+    }
+
+    // 吊销指定用户的全部会话（管理员）
+    crow::response revokeSessions(const crow::request& req, const std::string& id) {
+        // 验证权限
+        auto token = req.get_header_value("Authorization");
+        if (token.empty() || token.substr(0, 7) != "Bearer ") {
+            return errorResponse("Unauthorized", "Missing token", 401);
+        }
+        
+        if (!authManager->hasPermission(token.substr(7), Perm::ADMIN_ONLY)) {
+            return errorResponse("Forbidden", "Admin only", 403);
+        }
+
+        size_t revoked = authManager->revokeUserSessions(id);
+
+        // 记录日志
+        auto currentUser = authManager->getCurrentUser(token.substr(7));
+        if (currentUser.has_value()) {
+            logger->logOperation(currentUser.value().id, currentUser.value().username,
+                               "DELETE /users/" + id + "/sessions", "用户管理");
+        }
+
+        json result = {
+            {"userId", id},
+            {"revoked", revoked}
+        };
+        return jsonResponse(result);
+    }
+
     // 获取用户操作日志
     crow::response getUserLogs(const crow::request& req) {
         // 验证Token
@@ -579,19 +722,42 @@ public:
         // 解析字段选择参数
         std::vector<std::string> fields = parseFieldsParam(req);
 
-        auto logs = dataManager->getOperationLogs();
-        
-        // 筛选当前用户的日志
-        std::vector<OperationLog> userLogs;
-        for (const auto& log : logs) {
-            if (log.userId == currentUser.value().id) {
-                userLogs.push_back(log);
+        // 游标分页：?cursor= 或 X-Cursor，取值为上一页返回的 nextCursor
+        std::string cursorText;
+        if (req.url_params.get("cursor") != nullptr) {
+            cursorText = req.url_params.get("cursor");
+        } else {
+            cursorText = req.get_header_value("X-Cursor");
+        }
+        std::optional<LogPosition> cursor;
+        if (!cursorText.empty()) {
+            cursor = LogPosition::parse(cursorText);
+            if (!cursor.has_value()) {
+                return errorResponse("BadRequest", "Invalid cursor", 400);
             }
         }
 
-        // 分页（使用ISO日期格式）
-        auto result = paginateWithISO(userLogs, page, limit, 
-            [this](const std::string& ts) { return dataManager->convertToISO8601(ts); });
+        // 通过用户日志索引只读取当前用户的日志（从新到旧）
+        size_t skip = cursor.has_value() ? 0 : static_cast<size_t>(page - 1) * limit;
+        auto logPage = dataManager->getUserOperationLogs(currentUser.value().id, cursor, skip, limit);
+
+        json data = json::array();
+        for (const auto& log : logPage.logs) {
+            json item;
+            to_json_iso(item, log, [this](const std::string& ts) { return dataManager->convertToISO8601(ts); });
+            data.push_back(item);
+        }
+        int total = static_cast<int>(logPage.total);
+        json result = {
+            {"data", data},
+            {"total", total},
+            {"limit", limit},
+            {"nextCursor", logPage.next.has_value() ? json(logPage.next->toString()) : json(nullptr)}
+        };
+        if (!cursor.has_value()) {
+            result["page"] = page;
+            result["totalPages"] = (total + limit - 1) / limit;
+        }
         
         // 如果指定了fields，进行字段过滤
         if (!fields.empty() && result.contains("data")) {
@@ -611,7 +777,7 @@ public:
         // 记录日志（包含分页参数）
         std::string logMsg = "GET /user/logs | page=" + std::to_string(page) + 
                            ", limit=" + std::to_string(limit) + 
-                           ", total=" + std::to_string(userLogs.size());
+                           ", total=" + std::to_string(logPage.total);
         logger->logOperation(currentUser.value().id, currentUser.value().username,
                            logMsg, "用户管理");
 
@@ -8,39 +8,60 @@
 // 引入自定义头文件
 #include "include/models.h"
 #include "include/data_manager.h"
+#include "include/password_hasher.h"
+#include "include/log_pipeline.h"
 #include "include/auth.h"
 #include "include/middleware.h"
+#include "include/access_log.h"
 #include "include/user_service.h"
 #include "include/student_service.h"
 #include "include/course_service.h"
 #include "include/grade_service.h"
 #include "include/statistics_service.h"
 #include "include/report_service.h"
+#include "include/retention_task.h"
 #include "include/system_service.h"
 
 using json = nlohmann::json;
 
 int main() {
-    // 创建Crow应用实例
-    crow::SimpleApp app;
+    // 创建Crow应用实例（挂载访问日志中间件）
+    crow::App<AccessLogMiddleware> app;
 
     // 初始化数据管理器
     DataManager dataManager("./data");
     
+    // 初始化密码哈希线程池（独立于Crow工作线程，登录突发时不会占满请求线程）
+    PasswordHasherOptions hasherOptions;
+    hasherOptions.iterations = 100000;
+    hasherOptions.queueCapacity = 64;
+    hasherOptions.maxPendingChecks = 0; // 同时等待的登录校验不超过哈希工作线程数（低于Crow工作线程数），其余立即返回503
+    PasswordHasher passwordHasher(hasherOptions);
+
+    // 初始化统计分析线程池（临时筛选的全量扫描按分区并行执行）
+    ThreadPool analyticsPool(std::max(1u, std::thread::hardware_concurrency()));
+
+    // 初始化异步日志管道（请求线程只入队，后台线程批量写盘）
+    LogPipeline logPipeline(&dataManager);
+    app.get_middleware<AccessLogMiddleware>().init(&dataManager, &logPipeline);
+
     // 初始化认证管理器
-    AuthManager authManager(&dataManager);
+    AuthManager authManager(&dataManager, &passwordHasher, &logPipeline);
     
     // 初始化日志中间件
-    LogMiddleware logger(&dataManager);
+    LogMiddleware logger(&dataManager, &logPipeline);
+
+    // 初始化日志保留后台任务（启动时执行一次，之后每小时按保留天数删除过期日志段）
+    RetentionTask retentionTask(&dataManager, &logger, std::chrono::hours(1));
     
     // 初始化各个服务
     UserService userService(&dataManager, &authManager, &logger);
     StudentService studentService(&dataManager, &authManager, &logger);
     CourseService courseService(&dataManager, &authManager, &logger);
     GradeService gradeService(&dataManager, &authManager, &logger);
-    StatisticsService statisticsService(&dataManager, &authManager, &logger);
+    StatisticsService statisticsService(&dataManager, &authManager, &logger, &analyticsPool);
     ReportService reportService(&dataManager, &authManager, &logger);
-    SystemService systemService(&dataManager, &authManager, &logger);
+    SystemService systemService(&dataManager, &authManager, &logger, &retentionTask);
 
     // 设置CORS头（Crow框架中不需要显式调用）
 
@@ -64,7 +85,12 @@ int main() {
         std::string password = body["password"];
         std::string role = body["role"];
 
-        auto result = authManager.login(username, password, role);
+        std::optional<std::pair<std::string, User>> result;
+        try {
+            result = authManager.login(username, password, role);
+        } catch (const PasswordHasherBusy&) {
+            return errorResponse("ServiceUnavailable", "Too many login requests, please retry later", 503);
+        }
         if (!result.has_value()) {
             return errorResponse("Unauthorized", "Invalid credentials", 401);
         }
@@ -166,6 +192,18 @@ int main() {
         return userService.resetPassword(req, id);
     });
 
+    // 57. 获取活跃会话列表（管理员）
+    CROW_ROUTE(app, "/api/users/sessions").methods("GET"_method)
+    ([&](const crow::request& req) {
+        return userService.getSessions(req);
+    });
+
+    // 58. 吊销用户全部会话（管理员）
+    CROW_ROUTE(app, "/api/users/<string>/sessions").methods("DELETE"_method)
+    ([&](const crow::request& req, const std::string& id) {
+        return userService.revokeSessions(req, id);
+    });
+
     // ==================== 学生相关路由 ====================
 
     // 14. 获取学生列表
@@ -354,6 +392,24 @@ int main() {
         return statisticsService.generateReport(req);
     });
 
+    // 61. 分位数统计
+    CROW_ROUTE(app, "/api/statistics/percentiles").methods("GET"_method)
+    ([&](const crow::request& req) {
+        return statisticsService.getPercentiles(req);
+    });
+
+    // 62. 班级×课程统计立方体
+    CROW_ROUTE(app, "/api/statistics/cube").methods("GET"_method)
+    ([&](const crow::request& req) {
+        return statisticsService.getCube(req);
+    });
+
+    // 63. 批量统计
+    CROW_ROUTE(app, "/api/statistics/batch").methods("POST"_method)
+    ([&](const crow::request& req) {
+        return statisticsService.getBatchStatistics(req);
+    });
+
     // ==================== 报表管理路由 ====================
 
     // 44. 生成成绩单
@@ -436,6 +492,18 @@ int main() {
         return systemService.exportLogs(req);
     });
 
+    // 59. 日志保留任务状态
+    CROW_ROUTE(app, "/api/system/retention").methods("GET"_method)
+    ([&](const crow::request& req) {
+        return systemService.getRetentionStatus(req);
+    });
+
+    // 60. 检索操作日志（管理员）
+    CROW_ROUTE(app, "/api/system/operation-logs").methods("GET"_method)
+    ([&](const crow::request& req) {
+        return systemService.getOperationLogs(req);
+    });
+
     // ==================== 测试路由 ====================
 
     // 测试路由
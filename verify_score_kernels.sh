@@ -0,0 +1,79 @@
+#!/bin/bash
+
+# 验证分数列内核：AVX2 与标量实现在随机数据上结果一致
+
+echo "🔍 验证分数列内核..."
+
+CXX="${CXX:-clang++}"
+if ! command -v "$CXX" &> /dev/null; then
+    CXX=g++
+fi
+
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+cat > "$WORK_DIR/verify_score_kernels.cpp" << 'EOF'
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "score_kernels.h"
+
+using namespace ScoreKernels;
+
+int main() {
+#ifndef SCORE_KERNELS_AVX2
+    std::printf("⚠️  当前平台没有 AVX2 实现，只使用标量实现\n");
+    return 0;
+#else
+    if (!detail::avx2Supported()) {
+        std::printf("⚠️  当前 CPU 不支持 AVX2，只使用标量实现\n");
+        return 0;
+    }
+    std::mt19937 rng(20240601);
+    int failures = 0;
+    for (int round = 0; round < 5000; ++round) {
+        size_t n = rng() % 600;
+        std::vector<uint8_t> scores(n), mask(n);
+        int density = static_cast<int>(rng() % 4); // 0 全不选 … 3 全选
+        for (size_t i = 0; i < n; ++i) {
+            scores[i] = static_cast<uint8_t>(rng() % 101);
+            mask[i] = density == 3 || (density > 0 && rng() % 3 < static_cast<unsigned>(density))
+                          ? static_cast<uint8_t>(rng() % 255 + 1) : 0;
+        }
+        const uint8_t* s = scores.data();
+        const uint8_t* m = mask.data();
+        uint8_t threshold = static_cast<uint8_t>(rng() % 102);
+
+        uint8_t low = 255, high = 0, lowScalar = 255, highScalar = 0;
+        bool found = false, foundScalar = false;
+        detail::minMaxAvx2(s, m, n, low, high, found);
+        detail::minMaxScalar(s, m, 0, n, lowScalar, highScalar, foundScalar);
+
+        bool ok = detail::sumAvx2(s, m, n) == detail::sumScalar(s, m, 0, n) &&
+                  detail::countAtLeastAvx2(s, m, n, threshold) == detail::countAtLeastScalar(s, m, 0, n, threshold) &&
+                  found == foundScalar && (!found || (low == lowScalar && high == highScalar));
+
+        Histogram bins{};
+        histogram(s, m, n, bins);
+        Histogram expected{};
+        for (size_t i = 0; i < n; ++i) expected[s[i]] += m[i] != 0;
+        ok = ok && bins == expected;
+
+        if (!ok && ++failures <= 5) std::printf("❌ 第 %d 轮不一致（n=%zu）\n", round, n);
+    }
+    if (failures > 0) {
+        std::printf("❌ %d 轮结果不一致\n", failures);
+        return 1;
+    }
+    std::printf("✅ 5000 轮随机数据上 AVX2 与标量结果一致\n");
+    return 0;
+#endif
+}
+EOF
+
+if ! "$CXX" -std=c++17 -O2 -Iinclude "$WORK_DIR/verify_score_kernels.cpp" -o "$WORK_DIR/verify_score_kernels"; then
+    echo "❌ 编译失败"
+    exit 1
+fi
+
+"$WORK_DIR/verify_score_kernels"